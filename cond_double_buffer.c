@@ -18,6 +18,8 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 #include <SDL2/SDL.h>
 #include <pthread.h>
 #include <stdatomic.h>
@@ -212,6 +214,134 @@ draw_grid(cell** grid,
 }
 
 
+// One register of cells, as wide as the enabled instruction set allows
+// (build with -march=native). Cells are bools, so each lane is 0 or 1
+// and neighbour counts fit in the 8 bit lanes.
+#if defined(__AVX512BW__)
+typedef uint8_t cell_vec __attribute__((vector_size(64)));
+#elif defined(__AVX2__)
+typedef uint8_t cell_vec __attribute__((vector_size(32)));
+#else
+typedef uint8_t cell_vec __attribute__((vector_size(16)));
+#endif
+#define CELL_VEC_WIDTH sizeof(cell_vec)
+
+// Output rows computed per pass over a strip of columns.
+#define ROW_BLOCK 8
+
+cell_vec
+load_cells(const cell* src)
+{
+    cell_vec val;
+    memcpy(&val, src, sizeof(cell_vec));
+    return val;
+}
+
+void
+store_cells(cell* dst,
+            const cell_vec val)
+{
+    memcpy(dst, &val, sizeof(cell_vec));
+}
+
+// Scalar rule for one row, used when the grid is narrower than a vector.
+// A dead cell without 3 neighbours keeps whatever is in curr,
+// so cells toggled while iterating are not lost.
+void
+update_row(cell* restrict curr,
+           const cell* restrict above,
+           const cell* restrict row,
+           const cell* restrict below,
+           const size_t cols)
+{
+    for (size_t j = 0; j != cols; ++j)
+    {
+        const int alive_neighbors = above[j - 1] + above[j] + above[j + 1] +
+                                    row[j - 1] + row[j + 1] +
+                                    below[j - 1] + below[j] + below[j + 1];
+
+        if (row[j])
+            curr[j] = (alive_neighbors == 2 || alive_neighbors == 3);
+        else if (alive_neighbors == 3)
+            curr[j] = true;
+    }
+}
+
+// Sum of each cell and its two neighbours within the row.
+cell_vec
+row_sum(const cell* row,
+        const size_t col)
+{
+    return load_cells(row + col - 1) + load_cells(row + col) + load_cells(row + col + 1);
+}
+
+// Updates rows [row_begin, row_end) of the CELL_VEC_WIDTH columns
+// starting at col, walking down with a sliding window.
+// Every input row is loaded and summed horizontally once, and the sums
+// are kept in registers for the two output rows that need them after it.
+// The neighbour count is then 3 vector adds, and the rule is applied
+// with compares and blends, keeping the scalar rule's handling of curr.
+void
+update_strip(cell** restrict curr,
+             cell** restrict prev,
+             const size_t row_begin,
+             const size_t row_end,
+             const size_t col)
+{
+    cell_vec sum_above = row_sum(prev[row_begin - 1], col);
+    cell_vec sum_row = row_sum(prev[row_begin], col);
+    cell_vec center = load_cells(prev[row_begin] + col);
+
+    for (size_t i = row_begin; i != row_end; ++i)
+    {
+        const cell_vec sum_below = row_sum(prev[i + 1], col);
+        const cell_vec alive_neighbors = sum_above + sum_row + sum_below - center;
+
+        // Compares give 0xFF or 0 per lane
+        const cell_vec alive = (cell_vec)(center != 0);
+        const cell_vec two = (cell_vec)(alive_neighbors == 2);
+        const cell_vec three = (cell_vec)(alive_neighbors == 3);
+        const cell_vec kept = (cell_vec)(load_cells(curr[i] + col) != 0);
+
+        const cell_vec next = (alive & (two | three)) | (~alive & (three | kept));
+        store_cells(curr[i] + col, next & 1);
+
+        sum_above = sum_row;
+        sum_row = sum_below;
+        center = load_cells(prev[i + 1] + col);
+    }
+}
+
+void
+update_rows(cell** restrict curr,
+            cell** restrict prev,
+            const size_t row_begin,
+            const size_t row_end,
+            const size_t cols)
+{
+    if (cols < CELL_VEC_WIDTH)
+    {
+        for (size_t i = row_begin; i != row_end; ++i)
+            update_row(curr[i], prev[i - 1], prev[i], prev[i + 1], cols);
+        return;
+    }
+
+    // Blocks of ROW_BLOCK rows keep their input rows in cache
+    // while the strips move across them.
+    for (size_t i = row_begin; i < row_end; i += ROW_BLOCK)
+    {
+        const size_t block_end = (i + ROW_BLOCK < row_end) ? i + ROW_BLOCK : row_end;
+        for (size_t j = 0; j < cols; j += CELL_VEC_WIDTH)
+        {
+            // The last strip is moved back to end at the last column.
+            // Cells it recomputes get the same result, as the rule
+            // only depends on prev and on curr for dead cells.
+            const size_t col = (j + CELL_VEC_WIDTH <= cols) ? j : cols - CELL_VEC_WIDTH;
+            update_strip(curr, prev, i, block_end, col);
+        }
+    }
+}
+
 void*
 sub_update(cell** restrict curr,
            cell** restrict prev,
@@ -224,41 +354,7 @@ sub_update(cell** restrict curr,
     // Any live cell with two or three live neighbours lives on to the next generation.
     // Any live cell with more than three live neighbours dies, as if by overpopulation.
     // Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
-    for (size_t i = row_begin; i != row_end; ++i)
-    {
-        for (size_t j = 0; j != cols; ++j)
-        {
-            int alive_neighbors = 0;
-
-            // left side
-            alive_neighbors += prev[i - 1][j - 1];
-            alive_neighbors += prev[i - 1][j];
-            alive_neighbors += prev[i - 1][j + 1];
-
-            // above below
-            alive_neighbors += prev[i][j - 1];
-            alive_neighbors += prev[i][j + 1];
-
-            // right side
-            alive_neighbors += prev[i + 1][j - 1];
-            alive_neighbors += prev[i + 1][j];
-            alive_neighbors += prev[i + 1][j + 1];
-
-            if (prev[i][j])
-            {
-                if (alive_neighbors < 2)
-                    curr[i][j] = false;
-                if (alive_neighbors == 2 || alive_neighbors == 3)
-                    curr[i][j] = true;
-                if (alive_neighbors > 3)
-                    curr[i][j] = false;
-            }
-            else if (alive_neighbors == 3)
-            {
-                curr[i][j] = true;
-            }
-        }
-    }
+    update_rows(curr, prev, row_begin, row_end, cols);
 
     return NULL;
 }
@@ -0,0 +1,1625 @@
+///////////////////////////////////////////////////////////
+/// Container grid.
+/// Line of thought:
+/// - Layout:
+///     Dense bit rows waste memory on empty space, and lists
+///     of coordinates waste it on dense regions. The universe
+///     is cut in 256 x 256 tiles, so the offset of a cell in
+///     its tile (row * 256 + column) fits 16 bits, and every
+///     tile is stored like a roaring bitmap container:
+///     - empty: nothing at all,
+///     - array: sorted offsets of the live cells,
+///     - bitmap: one bit per cell, 8 KiB,
+///     - run: sorted (start, length - 1) pairs of offsets.
+///     After every generation a tile takes whichever of the
+///     three is smallest for its cells.
+/// - Kernels:
+///     Each container type is stepped as it is stored,
+///     arrays by counting the neighbours of the live cells,
+///     bitmaps with the bit-sliced word kernel and runs by
+///     sweeping the points where a row's runs begin or end,
+///     as the neighbour count is constant in between.
+///     Counting only pays off for a few hundred cells, a
+///     denser array is expanded and stepped as a bitmap, it
+///     is still stored as whatever is smallest afterwards.
+///     The ring of cells around a tile is read from its
+///     neighbours first, whatever their type.
+/// - Bounds checking:
+///     Like the other solutions everything outside the
+///     universe is dead.
+/// - Threads:
+///     Tiles are stepped from the current containers into
+///     the next ones, so threads share nothing but the
+///     generation counter.
+///
+/// Benchmark:
+///     ./container_grid bench [tiles] [density] [generations]
+///     steps a universe of tiles x tiles tiles, seeded with
+///     clusters of the given density (per mille), once with
+///     the containers chosen by size and once with bitmaps
+///     only, and checks they agree.
+///////////////////////////////////////////////////////////
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BORDER_WIDTH 1
+#define CELL_WIDTH 10
+#define CELL_HEIGHT 10
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 800
+#define CELL_COUNT (WINDOW_WIDTH / CELL_WIDTH)
+#define THREAD_COUNT 4
+
+#define TILE_SIZE 256
+#define TILE_CELLS (TILE_SIZE * TILE_SIZE)
+#define TILE_ROW_WORDS (TILE_SIZE / 64)
+#define BITMAP_WORDS (TILE_CELLS / 64)
+#define BITMAP_BYTES (BITMAP_WORDS * 8)
+// Rows -1 to TILE_SIZE, each with at most TILE_SIZE / 2 + 1 runs
+// and the two cells next to the tile
+#define MAX_INTERVALS ((TILE_SIZE + 2) * (TILE_SIZE / 2 + 3))
+// Above this many cells an array is quicker to step as a bitmap
+#define ARRAY_KERNEL_CELLS 512
+
+int
+sdl_init(SDL_Window** out_window,
+         SDL_Renderer** out_renderer,
+         const int window_width,
+         const int window_height)
+{
+    (*out_window) = NULL;
+    (*out_renderer) = NULL;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        goto failure;
+    }
+
+    (*out_window) = SDL_CreateWindow("container_conways",
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     window_width,
+                                     window_height,
+                                     SDL_WINDOW_SHOWN);
+
+    if ((*out_window) == NULL)
+    {
+        goto failure;
+    }
+
+    (*out_renderer) = SDL_CreateRenderer((*out_window),
+                                         -1,
+                                         SDL_RENDERER_ACCELERATED);
+
+    if ((*out_renderer) == NULL)
+    {
+        goto failure;
+    }
+
+    return 1;
+
+failure:
+    fprintf(stderr, "SDL_Error: %s\n", SDL_GetError());
+    SDL_DestroyRenderer((*out_renderer));
+    SDL_DestroyWindow((*out_window));
+    return 0;
+}
+
+void
+sdl_shutdown(SDL_Window* window,
+             SDL_Renderer* renderer)
+{
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+///////////////////////////////////////////////////////////
+/// Containers
+///////////////////////////////////////////////////////////
+typedef enum
+{
+    CONTAINER_EMPTY,
+    CONTAINER_ARRAY,
+    CONTAINER_BITMAP,
+    CONTAINER_RUN,
+} container_type;
+
+typedef struct
+{
+    container_type type;
+    // Live cells for arrays and bitmaps, runs for run containers
+    uint32_t count;
+    // Array: sorted offsets, run: sorted start, length - 1 pairs
+    uint16_t* values;
+    uint64_t* bits;
+} container;
+
+void
+destroy_container(container* c)
+{
+    free(c->values);
+    free(c->bits);
+    c->type = CONTAINER_EMPTY;
+    c->count = 0;
+    c->values = NULL;
+    c->bits = NULL;
+}
+
+size_t
+get_container_bytes(const container* c)
+{
+    switch (c->type)
+    {
+    case CONTAINER_ARRAY:
+        return c->count * sizeof(uint16_t);
+    case CONTAINER_BITMAP:
+        return BITMAP_BYTES;
+    case CONTAINER_RUN:
+        return c->count * 2 * sizeof(uint16_t);
+    default:
+        return 0;
+    }
+}
+
+// First index in a sorted array holding a value of at least `value`.
+size_t
+lower_bound(const uint16_t* values,
+            const size_t count,
+            const uint32_t value)
+{
+    size_t begin = 0;
+    size_t end = count;
+    while (begin != end)
+    {
+        const size_t middle = begin + (end - begin) / 2;
+        if (values[middle] < value)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+// First run of a run container that does not end before `offset`.
+size_t
+find_run(const container* c,
+         const uint32_t offset)
+{
+    size_t begin = 0;
+    size_t end = c->count;
+    while (begin != end)
+    {
+        const size_t middle = begin + (end - begin) / 2;
+        const uint32_t last = (uint32_t)c->values[middle * 2] + c->values[middle * 2 + 1];
+        if (last < offset)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+bool
+container_get(const container* c,
+              const uint32_t offset)
+{
+    switch (c->type)
+    {
+    case CONTAINER_ARRAY:
+    {
+        const size_t idx = lower_bound(c->values, c->count, offset);
+        return idx != c->count && c->values[idx] == offset;
+    }
+    case CONTAINER_BITMAP:
+        return (c->bits[offset / 64] >> (offset % 64)) & 1;
+    case CONTAINER_RUN:
+    {
+        const size_t idx = find_run(c, offset);
+        return idx != c->count && c->values[idx * 2] <= offset;
+    }
+    default:
+        return false;
+    }
+}
+
+// Sets bits [begin, end] of a bit array.
+void
+set_bit_range(uint64_t* bits,
+              const uint32_t begin,
+              const uint32_t end)
+{
+    for (uint32_t word = begin / 64; word <= end / 64; ++word)
+    {
+        const uint32_t low = (word == begin / 64) ? begin % 64 : 0;
+        const uint32_t high = (word == end / 64) ? end % 64 : 63;
+        const uint64_t below_high = (high == 63) ? ~0ULL : (1ULL << (high + 1)) - 1;
+        bits[word] |= below_high & ~((1ULL << low) - 1);
+    }
+}
+
+void
+container_to_bitmap(const container* c,
+                    uint64_t bits[BITMAP_WORDS])
+{
+    if (c->type == CONTAINER_BITMAP)
+    {
+        memcpy(bits, c->bits, BITMAP_BYTES);
+        return;
+    }
+
+    memset(bits, 0, BITMAP_BYTES);
+    if (c->type == CONTAINER_ARRAY)
+    {
+        for (size_t i = 0; i != c->count; ++i)
+            bits[c->values[i] / 64] |= 1ULL << (c->values[i] % 64);
+    }
+    else if (c->type == CONTAINER_RUN)
+    {
+        for (size_t i = 0; i != c->count; ++i)
+            set_bit_range(bits, c->values[i * 2], (uint32_t)c->values[i * 2] + c->values[i * 2 + 1]);
+    }
+}
+
+// Row y of a tile as TILE_ROW_WORDS words.
+void
+container_row_bits(const container* c,
+                   const uint32_t y,
+                   uint64_t out[TILE_ROW_WORDS])
+{
+    memset(out, 0, TILE_ROW_WORDS * sizeof(uint64_t));
+    const uint32_t row_begin = y * TILE_SIZE;
+    const uint32_t row_last = row_begin + TILE_SIZE - 1;
+
+    if (c->type == CONTAINER_BITMAP)
+    {
+        memcpy(out, &c->bits[y * TILE_ROW_WORDS], TILE_ROW_WORDS * sizeof(uint64_t));
+    }
+    else if (c->type == CONTAINER_ARRAY)
+    {
+        for (size_t i = lower_bound(c->values, c->count, row_begin);
+             i != c->count && c->values[i] <= row_last;
+             ++i)
+        {
+            const uint32_t x = c->values[i] - row_begin;
+            out[x / 64] |= 1ULL << (x % 64);
+        }
+    }
+    else if (c->type == CONTAINER_RUN)
+    {
+        for (size_t i = find_run(c, row_begin);
+             i != c->count && c->values[i * 2] <= row_last;
+             ++i)
+        {
+            const uint32_t first = c->values[i * 2];
+            const uint32_t last = first + c->values[i * 2 + 1];
+            set_bit_range(out,
+                          (first > row_begin) ? first - row_begin : 0,
+                          (last < row_last) ? last - row_begin : TILE_SIZE - 1);
+        }
+    }
+}
+
+// Column x of a tile as TILE_ROW_WORDS words, bit y for row y.
+void
+container_column_bits(const container* c,
+                      const uint32_t x,
+                      uint64_t out[TILE_ROW_WORDS])
+{
+    memset(out, 0, TILE_ROW_WORDS * sizeof(uint64_t));
+
+    if (c->type == CONTAINER_BITMAP)
+    {
+        for (uint32_t y = 0; y != TILE_SIZE; ++y)
+        {
+            const uint64_t bit = (c->bits[y * TILE_ROW_WORDS + x / 64] >> (x % 64)) & 1;
+            out[y / 64] |= bit << (y % 64);
+        }
+    }
+    else if (c->type == CONTAINER_ARRAY)
+    {
+        for (size_t i = 0; i != c->count; ++i)
+        {
+            if (c->values[i] % TILE_SIZE == x)
+            {
+                const uint32_t y = c->values[i] / TILE_SIZE;
+                out[y / 64] |= 1ULL << (y % 64);
+            }
+        }
+    }
+    else if (c->type == CONTAINER_RUN)
+    {
+        for (size_t i = 0; i != c->count; ++i)
+        {
+            const uint32_t first = c->values[i * 2];
+            const uint32_t last = first + c->values[i * 2 + 1];
+            for (uint32_t y = first / TILE_SIZE; y <= last / TILE_SIZE; ++y)
+            {
+                const uint32_t offset = y * TILE_SIZE + x;
+                if (offset >= first && offset <= last)
+                    out[y / 64] |= 1ULL << (y % 64);
+            }
+        }
+    }
+}
+
+// Live cells and runs of live cells in a bitmap.
+void
+count_bitmap(const uint64_t bits[BITMAP_WORDS],
+             uint32_t* out_cells,
+             uint32_t* out_runs)
+{
+    uint32_t cells = 0;
+    uint32_t runs = 0;
+    uint64_t carry = 0;
+    for (size_t w = 0; w != BITMAP_WORDS; ++w)
+    {
+        cells += __builtin_popcountll(bits[w]);
+        // A run starts at every live cell whose predecessor is dead
+        runs += __builtin_popcountll(bits[w] & ~((bits[w] << 1) | carry));
+        carry = bits[w] >> 63;
+    }
+    (*out_cells) = cells;
+    (*out_runs) = runs;
+}
+
+// Smallest container for the given cells, bitmaps only when not adaptive.
+container_type
+choose_container(const uint32_t cells,
+                 const uint32_t runs,
+                 const bool adaptive)
+{
+    if (cells == 0)
+        return CONTAINER_EMPTY;
+    if (!adaptive)
+        return CONTAINER_BITMAP;
+
+    const size_t array_bytes = cells * sizeof(uint16_t);
+    const size_t run_bytes = runs * 2 * sizeof(uint16_t);
+
+    if (run_bytes < array_bytes && run_bytes < BITMAP_BYTES)
+        return CONTAINER_RUN;
+    if (array_bytes < BITMAP_BYTES)
+        return CONTAINER_ARRAY;
+    return CONTAINER_BITMAP;
+}
+
+container
+container_from_bitmap(const uint64_t bits[BITMAP_WORDS],
+                      const bool adaptive)
+{
+    uint32_t cells;
+    uint32_t runs;
+    count_bitmap(bits, &cells, &runs);
+
+    container c =
+    {
+        .type = choose_container(cells, runs, adaptive),
+    };
+
+    if (c.type == CONTAINER_BITMAP)
+    {
+        c.count = cells;
+        c.bits = malloc(BITMAP_BYTES);
+        memcpy(c.bits, bits, BITMAP_BYTES);
+    }
+    else if (c.type == CONTAINER_ARRAY)
+    {
+        c.count = cells;
+        c.values = malloc(cells * sizeof(uint16_t));
+        size_t n = 0;
+        for (size_t w = 0; w != BITMAP_WORDS; ++w)
+        {
+            for (uint64_t word = bits[w]; word != 0; word &= word - 1)
+                c.values[n++] = w * 64 + __builtin_ctzll(word);
+        }
+    }
+    else if (c.type == CONTAINER_RUN)
+    {
+        c.count = runs;
+        c.values = malloc(runs * 2 * sizeof(uint16_t));
+        size_t n = 0;
+        uint32_t offset = 0;
+        while (n != runs)
+        {
+            // Skip to the next live cell, then to the next dead one
+            while (!((bits[offset / 64] >> (offset % 64)) & 1))
+            {
+                const uint64_t rest = bits[offset / 64] >> (offset % 64);
+                offset = (rest != 0) ? offset + __builtin_ctzll(rest) : (offset / 64 + 1) * 64;
+            }
+            const uint32_t first = offset;
+            while (offset != TILE_CELLS && ((bits[offset / 64] >> (offset % 64)) & 1))
+            {
+                const uint64_t rest = ~bits[offset / 64] >> (offset % 64);
+                offset = (rest != 0) ? offset + __builtin_ctzll(rest) : (offset / 64 + 1) * 64;
+            }
+            c.values[n * 2] = first;
+            c.values[n * 2 + 1] = offset - first - 1;
+            ++n;
+        }
+    }
+
+    return c;
+}
+
+// Container for sorted offsets, `bits` is scratch space.
+container
+container_from_array(const uint16_t* values,
+                     const uint32_t cells,
+                     const bool adaptive,
+                     uint64_t bits[BITMAP_WORDS])
+{
+    uint32_t runs = 0;
+    for (size_t i = 0; i != cells; ++i)
+        runs += (i == 0) || (values[i - 1] + 1 != values[i]);
+
+    container c =
+    {
+        .type = choose_container(cells, runs, adaptive),
+    };
+
+    if (c.type == CONTAINER_ARRAY)
+    {
+        c.count = cells;
+        c.values = malloc(cells * sizeof(uint16_t));
+        memcpy(c.values, values, cells * sizeof(uint16_t));
+    }
+    else if (c.type != CONTAINER_EMPTY)
+    {
+        const container source =
+        {
+            .type = CONTAINER_ARRAY,
+            .count = cells,
+            .values = (uint16_t*)values,
+        };
+        container_to_bitmap(&source, bits);
+        c = container_from_bitmap(bits, adaptive);
+    }
+
+    return c;
+}
+
+// Container for sorted runs, `bits` is scratch space.
+container
+container_from_runs(const uint16_t* values,
+                    const uint32_t runs,
+                    const bool adaptive,
+                    uint64_t bits[BITMAP_WORDS])
+{
+    uint32_t cells = 0;
+    for (size_t i = 0; i != runs; ++i)
+        cells += values[i * 2 + 1] + 1;
+
+    container c =
+    {
+        .type = choose_container(cells, runs, adaptive),
+    };
+
+    if (c.type == CONTAINER_RUN)
+    {
+        c.count = runs;
+        c.values = malloc(runs * 2 * sizeof(uint16_t));
+        memcpy(c.values, values, runs * 2 * sizeof(uint16_t));
+    }
+    else if (c.type != CONTAINER_EMPTY)
+    {
+        const container source =
+        {
+            .type = CONTAINER_RUN,
+            .count = runs,
+            .values = (uint16_t*)values,
+        };
+        container_to_bitmap(&source, bits);
+        c = container_from_bitmap(bits, adaptive);
+    }
+
+    return c;
+}
+
+///////////////////////////////////////////////////////////
+/// Universe
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    // Current and next containers, tile_rows * tile_cols each
+    container* tiles[2];
+    size_t current;
+    size_t tile_rows;
+    size_t tile_cols;
+    // Choose containers by size, otherwise bitmaps only
+    bool adaptive;
+} universe;
+
+universe
+create_universe(const size_t tile_rows,
+                const size_t tile_cols,
+                const bool adaptive)
+{
+    universe u =
+    {
+        .tiles =
+        {
+            calloc(tile_rows * tile_cols, sizeof(container)),
+            calloc(tile_rows * tile_cols, sizeof(container)),
+        },
+        .current = 0,
+        .tile_rows = tile_rows,
+        .tile_cols = tile_cols,
+        .adaptive = adaptive,
+    };
+    return u;
+}
+
+void
+destroy_universe(universe* u)
+{
+    for (size_t i = 0; i != u->tile_rows * u->tile_cols; ++i)
+    {
+        destroy_container(&u->tiles[0][i]);
+        destroy_container(&u->tiles[1][i]);
+    }
+    free(u->tiles[0]);
+    free(u->tiles[1]);
+    u->tiles[0] = NULL;
+    u->tiles[1] = NULL;
+}
+
+// Current container of a tile, NULL outside the universe.
+const container*
+get_tile(const universe* u,
+         const int64_t tile_row,
+         const int64_t tile_col)
+{
+    if (tile_row < 0 || tile_row >= (int64_t)u->tile_rows ||
+        tile_col < 0 || tile_col >= (int64_t)u->tile_cols)
+    {
+        return NULL;
+    }
+    return &u->tiles[u->current][tile_row * u->tile_cols + tile_col];
+}
+
+bool
+get_cell(const universe* u,
+         const size_t row,
+         const size_t col)
+{
+    const container* c = get_tile(u, row / TILE_SIZE, col / TILE_SIZE);
+    return c != NULL && container_get(c, (row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE);
+}
+
+// Goes through a bitmap, fine for edits, not for loading whole patterns.
+void
+set_cell(universe* u,
+         const size_t row,
+         const size_t col,
+         const bool val)
+{
+    container* c = &u->tiles[u->current][(row / TILE_SIZE) * u->tile_cols + col / TILE_SIZE];
+    const uint32_t offset = (row % TILE_SIZE) * TILE_SIZE + col % TILE_SIZE;
+
+    uint64_t* bits = malloc(BITMAP_BYTES);
+    container_to_bitmap(c, bits);
+    if (val)
+        bits[offset / 64] |= 1ULL << (offset % 64);
+    else
+        bits[offset / 64] &= ~(1ULL << (offset % 64));
+
+    destroy_container(c);
+    (*c) = container_from_bitmap(bits, u->adaptive);
+    free(bits);
+}
+
+///////////////////////////////////////////////////////////
+/// Kernels
+///////////////////////////////////////////////////////////
+// Cells around a tile, read from its neighbours.
+typedef struct
+{
+    // Row -1 and row TILE_SIZE, bit x for column x
+    uint64_t top[TILE_ROW_WORDS];
+    uint64_t bottom[TILE_ROW_WORDS];
+    // Column -1 and column TILE_SIZE, bit y for row y
+    uint64_t left[TILE_ROW_WORDS];
+    uint64_t right[TILE_ROW_WORDS];
+    // Top left, top right, bottom left, bottom right
+    bool corners[4];
+} halo;
+
+// Returns false if there is nothing alive around the tile.
+bool
+gather_halo(const universe* u,
+            const size_t tile_row,
+            const size_t tile_col,
+            halo* h)
+{
+    const int64_t r = tile_row;
+    const int64_t c = tile_col;
+    const container* top = get_tile(u, r - 1, c);
+    const container* bottom = get_tile(u, r + 1, c);
+    const container* left = get_tile(u, r, c - 1);
+    const container* right = get_tile(u, r, c + 1);
+    const container* corners[4] =
+    {
+        get_tile(u, r - 1, c - 1),
+        get_tile(u, r - 1, c + 1),
+        get_tile(u, r + 1, c - 1),
+        get_tile(u, r + 1, c + 1),
+    };
+    const uint32_t corner_offsets[4] =
+    {
+        TILE_CELLS - 1,
+        TILE_CELLS - TILE_SIZE,
+        TILE_SIZE - 1,
+        0,
+    };
+
+    memset(h, 0, sizeof(halo));
+    if (top != NULL)
+        container_row_bits(top, TILE_SIZE - 1, h->top);
+    if (bottom != NULL)
+        container_row_bits(bottom, 0, h->bottom);
+    if (left != NULL)
+        container_column_bits(left, TILE_SIZE - 1, h->left);
+    if (right != NULL)
+        container_column_bits(right, 0, h->right);
+
+    bool any = false;
+    for (size_t i = 0; i != 4; ++i)
+    {
+        h->corners[i] = corners[i] != NULL && container_get(corners[i], corner_offsets[i]);
+        any |= h->corners[i];
+    }
+    for (size_t w = 0; w != TILE_ROW_WORDS; ++w)
+        any |= (h->top[w] | h->bottom[w] | h->left[w] | h->right[w]) != 0;
+
+    return any;
+}
+
+// Scratch space of one thread.
+typedef struct
+{
+    // Low nibble: live neighbours, 0x10: alive
+    uint8_t* counts;
+    uint16_t* touched;
+    uint16_t* values;
+    uint16_t* sorted;
+    uint64_t* bits;
+    uint64_t* expanded;
+    int16_t* intervals;
+} kernel_scratch;
+
+kernel_scratch
+create_scratch()
+{
+    kernel_scratch s =
+    {
+        .counts = calloc(TILE_CELLS, sizeof(uint8_t)),
+        .touched = malloc(TILE_CELLS * sizeof(uint16_t)),
+        .values = malloc(TILE_CELLS * sizeof(uint16_t)),
+        .sorted = malloc(TILE_CELLS * sizeof(uint16_t)),
+        .bits = malloc(BITMAP_BYTES),
+        .expanded = malloc(BITMAP_BYTES),
+        .intervals = malloc(MAX_INTERVALS * 2 * sizeof(int16_t)),
+    };
+    return s;
+}
+
+void
+destroy_scratch(kernel_scratch* s)
+{
+    free(s->counts);
+    free(s->touched);
+    free(s->values);
+    free(s->sorted);
+    free(s->bits);
+    free(s->expanded);
+    free(s->intervals);
+}
+
+// Next state of 64 cells at once, given the 8 words of their
+// neighbours (already shifted into place) and their current state.
+// The neighbour counts are summed bit-sliced through an adder tree,
+// a cell lives if the count is 3, or 2 and it is already alive.
+uint64_t
+life_rule_word(const uint64_t neighbors[8],
+               const uint64_t alive)
+{
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t ones = d_xor ^ c_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t twos = e_sum ^ d_carry;
+    const uint64_t f_carry = e_sum & d_carry;
+
+    return twos & ~(e_carry | f_carry) & (ones | alive);
+}
+
+// Row y of a bitmap tile, from -1 to TILE_SIZE, with the cells
+// to its left and right.
+const uint64_t*
+get_bitmap_row(const uint64_t* bits,
+               const halo* h,
+               const int y,
+               uint64_t* west,
+               uint64_t* east)
+{
+    if (y < 0)
+    {
+        (*west) = h->corners[0];
+        (*east) = h->corners[1];
+        return h->top;
+    }
+    if (y == TILE_SIZE)
+    {
+        (*west) = h->corners[2];
+        (*east) = h->corners[3];
+        return h->bottom;
+    }
+    (*west) = (h->left[y / 64] >> (y % 64)) & 1;
+    (*east) = (h->right[y / 64] >> (y % 64)) & 1;
+    return &bits[y * TILE_ROW_WORDS];
+}
+
+// Bits of a row shifted so bit x holds column x - 1, and column x + 1.
+void
+shift_row(const uint64_t* row,
+          const uint64_t west,
+          const uint64_t east,
+          const size_t w,
+          uint64_t* out_west,
+          uint64_t* out_east)
+{
+    const uint64_t before = (w != 0) ? row[w - 1] >> 63 : west;
+    const uint64_t after = (w + 1 != TILE_ROW_WORDS) ? row[w + 1] & 1 : east;
+    (*out_west) = (row[w] << 1) | before;
+    (*out_east) = (row[w] >> 1) | (after << 63);
+}
+
+container
+step_bitmap(const container* c,
+            const halo* h,
+            const bool adaptive,
+            kernel_scratch* s)
+{
+    for (int y = 0; y != TILE_SIZE; ++y)
+    {
+        uint64_t above_west, above_east, curr_west, curr_east, below_west, below_east;
+        const uint64_t* above = get_bitmap_row(c->bits, h, y - 1, &above_west, &above_east);
+        const uint64_t* curr = get_bitmap_row(c->bits, h, y, &curr_west, &curr_east);
+        const uint64_t* below = get_bitmap_row(c->bits, h, y + 1, &below_west, &below_east);
+
+        for (size_t w = 0; w != TILE_ROW_WORDS; ++w)
+        {
+            uint64_t neighbors[8];
+            shift_row(above, above_west, above_east, w, &neighbors[0], &neighbors[2]);
+            neighbors[1] = above[w];
+            shift_row(curr, curr_west, curr_east, w, &neighbors[3], &neighbors[4]);
+            shift_row(below, below_west, below_east, w, &neighbors[5], &neighbors[7]);
+            neighbors[6] = below[w];
+
+            s->bits[y * TILE_ROW_WORDS + w] = life_rule_word(neighbors, curr[w]);
+        }
+    }
+
+    return container_from_bitmap(s->bits, adaptive);
+}
+
+// Counts a live cell at (x, y), which may lie in the halo,
+// as a neighbour of the cells around it inside the tile.
+void
+count_neighbors(kernel_scratch* s,
+                size_t* touched,
+                const int x,
+                const int y)
+{
+    // Most cells are not on the tile edge, no bounds to check
+    if (x > 0 && x < TILE_SIZE - 1 && y > 0 && y < TILE_SIZE - 1)
+    {
+        const int deltas[8] =
+        {
+            -TILE_SIZE - 1, -TILE_SIZE, -TILE_SIZE + 1,
+            -1, 1,
+            TILE_SIZE - 1, TILE_SIZE, TILE_SIZE + 1,
+        };
+        const int center = y * TILE_SIZE + x;
+        for (size_t i = 0; i != 8; ++i)
+        {
+            const uint16_t offset = center + deltas[i];
+            s->touched[(*touched)] = offset;
+            (*touched) += s->counts[offset] == 0;
+            ++s->counts[offset];
+        }
+        return;
+    }
+
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            const int nx = x + dx;
+            const int ny = y + dy;
+            if ((dx == 0 && dy == 0) ||
+                nx < 0 || nx >= TILE_SIZE || ny < 0 || ny >= TILE_SIZE)
+            {
+                continue;
+            }
+
+            const uint16_t offset = ny * TILE_SIZE + nx;
+            if (s->counts[offset] == 0)
+                s->touched[(*touched)++] = offset;
+            ++s->counts[offset];
+        }
+    }
+}
+
+void
+count_halo_bits(kernel_scratch* s,
+                size_t* touched,
+                const uint64_t bits[TILE_ROW_WORDS],
+                const int fixed,
+                const bool is_row)
+{
+    for (size_t w = 0; w != TILE_ROW_WORDS; ++w)
+    {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1)
+        {
+            const int pos = w * 64 + __builtin_ctzll(word);
+            if (is_row)
+                count_neighbors(s, touched, pos, fixed);
+            else
+                count_neighbors(s, touched, fixed, pos);
+        }
+    }
+}
+
+// Sorts offsets with two byte-wise counting passes.
+void
+sort_offsets(uint16_t* values,
+             uint16_t* tmp,
+             const size_t count)
+{
+    for (size_t shift = 0; shift != 16; shift += 8)
+    {
+        size_t starts[257] = {0};
+        for (size_t i = 0; i != count; ++i)
+            ++starts[((values[i] >> shift) & 0xFF) + 1];
+        for (size_t b = 0; b != 256; ++b)
+            starts[b + 1] += starts[b];
+        for (size_t i = 0; i != count; ++i)
+            tmp[starts[(values[i] >> shift) & 0xFF]++] = values[i];
+        memcpy(values, tmp, count * sizeof(uint16_t));
+    }
+}
+
+// Steps an array (or empty) container by counting the neighbours of
+// the live cells, only cells next to a live one can be alive next.
+container
+step_array(const container* c,
+           const halo* h,
+           const bool adaptive,
+           kernel_scratch* s)
+{
+    size_t touched = 0;
+
+    for (size_t i = 0; i != c->count; ++i)
+    {
+        const uint16_t offset = c->values[i];
+        if (s->counts[offset] == 0)
+            s->touched[touched++] = offset;
+        s->counts[offset] |= 0x10;
+    }
+    for (size_t i = 0; i != c->count; ++i)
+        count_neighbors(s, &touched, c->values[i] % TILE_SIZE, c->values[i] / TILE_SIZE);
+
+    count_halo_bits(s, &touched, h->top, -1, true);
+    count_halo_bits(s, &touched, h->bottom, TILE_SIZE, true);
+    count_halo_bits(s, &touched, h->left, -1, false);
+    count_halo_bits(s, &touched, h->right, TILE_SIZE, false);
+    const int corner_x[4] = {-1, TILE_SIZE, -1, TILE_SIZE};
+    const int corner_y[4] = {-1, -1, TILE_SIZE, TILE_SIZE};
+    for (size_t i = 0; i != 4; ++i)
+    {
+        if (h->corners[i])
+            count_neighbors(s, &touched, corner_x[i], corner_y[i]);
+    }
+
+    size_t cells = 0;
+    for (size_t i = 0; i != touched; ++i)
+    {
+        const uint16_t offset = s->touched[i];
+        const uint8_t neighbors = s->counts[offset] & 0x0F;
+        const bool alive = s->counts[offset] & 0x10;
+        if (neighbors == 3 || (neighbors == 2 && alive))
+            s->values[cells++] = offset;
+        s->counts[offset] = 0;
+    }
+
+    sort_offsets(s->values, s->sorted, cells);
+    return container_from_array(s->values, cells, adaptive, s->bits);
+}
+
+// Appends the runs of a row bitmap as intervals, with the cells
+// to its left and right as columns -1 and TILE_SIZE.
+size_t
+append_row_intervals(int16_t* intervals,
+                     size_t count,
+                     const uint64_t row[TILE_ROW_WORDS],
+                     const bool west,
+                     const bool east)
+{
+    if (west)
+    {
+        intervals[count * 2] = -1;
+        intervals[count * 2 + 1] = -1;
+        ++count;
+    }
+
+    int x = 0;
+    while (x < TILE_SIZE)
+    {
+        const uint64_t live = row[x / 64] >> (x % 64);
+        if (live == 0)
+        {
+            x = (x / 64 + 1) * 64;
+            continue;
+        }
+        x += __builtin_ctzll(live);
+
+        const int first = x;
+        while (x < TILE_SIZE)
+        {
+            const uint64_t dead = ~row[x / 64] >> (x % 64);
+            if (dead != 0)
+            {
+                x += __builtin_ctzll(dead);
+                break;
+            }
+            x = (x / 64 + 1) * 64;
+        }
+        intervals[count * 2] = first;
+        intervals[count * 2 + 1] = x - 1;
+        ++count;
+    }
+
+    if (east)
+    {
+        intervals[count * 2] = TILE_SIZE;
+        intervals[count * 2 + 1] = TILE_SIZE;
+        ++count;
+    }
+    return count;
+}
+
+// Live cells among columns [x - 1, x + 1] of a row of intervals,
+// `first` moves forward as x grows.
+int
+count_window(const int16_t* intervals,
+             const size_t count,
+             size_t* first,
+             const int x)
+{
+    while ((*first) != count && intervals[(*first) * 2 + 1] < x - 1)
+        ++(*first);
+
+    int live = 0;
+    for (size_t i = (*first); i != count && intervals[i * 2] <= x + 1; ++i)
+    {
+        const int begin = (intervals[i * 2] > x - 1) ? intervals[i * 2] : x - 1;
+        const int end = (intervals[i * 2 + 1] < x + 1) ? intervals[i * 2 + 1] : x + 1;
+        live += end - begin + 1;
+    }
+    return live;
+}
+
+bool
+interval_contains(const int16_t* intervals,
+                  const size_t count,
+                  const size_t first,
+                  const int x)
+{
+    for (size_t i = first; i != count && intervals[i * 2] <= x; ++i)
+    {
+        if (intervals[i * 2 + 1] >= x)
+            return true;
+    }
+    return false;
+}
+
+// Steps a run container one row at a time. Within a row the
+// neighbour count only changes around the ends of the runs in the
+// rows above, below and itself, so the next state is worked out once
+// per stretch between those points and written as a run.
+container
+step_runs(const container* c,
+          const halo* h,
+          const bool adaptive,
+          kernel_scratch* s)
+{
+    // Rows -1 to TILE_SIZE as intervals, row y starting at row_start[y + 1]
+    size_t row_start[TILE_SIZE + 3];
+    int16_t* intervals = s->intervals;
+    size_t count = 0;
+
+    row_start[0] = 0;
+    count = append_row_intervals(intervals, count, h->top, h->corners[0], h->corners[1]);
+
+    size_t run = 0;
+    for (uint32_t y = 0; y != TILE_SIZE; ++y)
+    {
+        row_start[y + 1] = count;
+        const uint32_t row_begin = y * TILE_SIZE;
+        const uint32_t row_last = row_begin + TILE_SIZE - 1;
+
+        if ((h->left[y / 64] >> (y % 64)) & 1)
+        {
+            intervals[count * 2] = -1;
+            intervals[count * 2 + 1] = -1;
+            ++count;
+        }
+
+        // Runs may go on past the end of a row, so one can be seen again
+        while (run != c->count && c->values[run * 2] <= row_last)
+        {
+            const uint32_t first = c->values[run * 2];
+            const uint32_t last = first + c->values[run * 2 + 1];
+            intervals[count * 2] = (first > row_begin) ? first - row_begin : 0;
+            intervals[count * 2 + 1] = (last < row_last) ? last - row_begin : TILE_SIZE - 1;
+            ++count;
+
+            if (last > row_last)
+                break;
+            ++run;
+        }
+
+        if ((h->right[y / 64] >> (y % 64)) & 1)
+        {
+            intervals[count * 2] = TILE_SIZE;
+            intervals[count * 2 + 1] = TILE_SIZE;
+            ++count;
+        }
+    }
+
+    row_start[TILE_SIZE + 1] = count;
+    count = append_row_intervals(intervals, count, h->bottom, h->corners[2], h->corners[3]);
+    row_start[TILE_SIZE + 2] = count;
+
+    uint16_t* runs = s->values;
+    size_t run_count = 0;
+
+    for (int y = 0; y != TILE_SIZE; ++y)
+    {
+        const int16_t* rows[3];
+        size_t sizes[3];
+        size_t firsts[3] = {0, 0, 0};
+        for (size_t r = 0; r != 3; ++r)
+        {
+            rows[r] = &intervals[row_start[y + r] * 2];
+            sizes[r] = row_start[y + r + 1] - row_start[y + r];
+        }
+
+        // Columns where the neighbour count or the cell may change,
+        // the end of the row is one too
+        uint64_t breaks[TILE_ROW_WORDS + 1] = {0};
+        breaks[0] = 1;
+        breaks[TILE_ROW_WORDS] = 1;
+        for (size_t r = 0; r != 3; ++r)
+        {
+            for (size_t i = 0; i != sizes[r]; ++i)
+            {
+                const int points[6] =
+                {
+                    rows[r][i * 2] - 1, rows[r][i * 2], rows[r][i * 2] + 1,
+                    rows[r][i * 2 + 1], rows[r][i * 2 + 1] + 1, rows[r][i * 2 + 1] + 2,
+                };
+                for (size_t p = 0; p != 6; ++p)
+                {
+                    if (points[p] >= 0 && points[p] <= TILE_SIZE)
+                        breaks[points[p] / 64] |= 1ULL << (points[p] % 64);
+                }
+            }
+        }
+
+        int x = 0;
+        while (x != TILE_SIZE)
+        {
+            // Next break after x
+            const uint64_t rest = (x % 64 == 63) ? 0 : breaks[x / 64] >> (x % 64 + 1) << (x % 64 + 1);
+            int next = (rest != 0) ? (x / 64) * 64 + __builtin_ctzll(rest) : -1;
+            for (size_t w = x / 64 + 1; next < 0; ++w)
+            {
+                if (breaks[w] != 0)
+                    next = w * 64 + __builtin_ctzll(breaks[w]);
+            }
+            if (next > TILE_SIZE)
+                next = TILE_SIZE;
+
+            const bool alive = interval_contains(rows[1], sizes[1], firsts[1], x);
+            const int neighbors = count_window(rows[0], sizes[0], &firsts[0], x)
+                                + count_window(rows[1], sizes[1], &firsts[1], x)
+                                + count_window(rows[2], sizes[2], &firsts[2], x)
+                                - alive;
+
+            if (neighbors == 3 || (neighbors == 2 && alive))
+            {
+                const uint32_t first = y * TILE_SIZE + x;
+                const uint32_t last = y * TILE_SIZE + next - 1;
+                if (run_count != 0 &&
+                    (uint32_t)runs[(run_count - 1) * 2] + runs[(run_count - 1) * 2 + 1] + 1 == first)
+                {
+                    runs[(run_count - 1) * 2 + 1] += last - first + 1;
+                }
+                else
+                {
+                    runs[run_count * 2] = first;
+                    runs[run_count * 2 + 1] = last - first;
+                    ++run_count;
+                }
+            }
+            x = next;
+        }
+    }
+
+    return container_from_runs(runs, run_count, adaptive, s->bits);
+}
+
+// Steps one tile into the next containers.
+void
+step_tile(universe* u,
+          const size_t tile,
+          kernel_scratch* s)
+{
+    const container* c = &u->tiles[u->current][tile];
+    container* next = &u->tiles[1 - u->current][tile];
+    destroy_container(next);
+
+    halo h;
+    const bool any_around = gather_halo(u, tile / u->tile_cols, tile % u->tile_cols, &h);
+    if (c->type == CONTAINER_EMPTY && !any_around)
+        return;
+
+    switch (c->type)
+    {
+    case CONTAINER_BITMAP:
+        (*next) = step_bitmap(c, &h, u->adaptive, s);
+        break;
+    case CONTAINER_RUN:
+        (*next) = step_runs(c, &h, u->adaptive, s);
+        break;
+    default:
+        if (c->count <= ARRAY_KERNEL_CELLS)
+        {
+            (*next) = step_array(c, &h, u->adaptive, s);
+        }
+        else
+        {
+            // Stored small, stepped fast
+            container_to_bitmap(c, s->expanded);
+            const container expanded =
+            {
+                .type = CONTAINER_BITMAP,
+                .count = c->count,
+                .bits = s->expanded,
+            };
+            (*next) = step_bitmap(&expanded, &h, u->adaptive, s);
+        }
+        break;
+    }
+}
+
+///////////////////////////////////////////////////////////
+/// SDL
+///////////////////////////////////////////////////////////
+bool
+handle_events(universe* u,
+              bool* iterate)
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_QUIT ||
+            (event.type == SDL_KEYUP &&
+             event.key.keysym.sym == SDLK_ESCAPE))
+        {
+            return false;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_SPACE)
+        {
+            (*iterate) = !(*iterate);
+        }
+
+        if (event.type == SDL_MOUSEBUTTONUP)
+        {
+            const int selected_col = event.button.x / CELL_WIDTH;
+            const int selected_row = event.button.y / CELL_HEIGHT;
+
+            if (selected_col >= 0 && selected_col < CELL_COUNT &&
+                selected_row >= 0 && selected_row < CELL_COUNT)
+            {
+                set_cell(u, selected_row, selected_col,
+                         !get_cell(u, selected_row, selected_col));
+            }
+        }
+    }
+    return true;
+}
+
+// Draws the top left corner of the universe
+void
+draw_grid(const universe* u,
+          SDL_Renderer* renderer)
+{
+    SDL_Color prev_color;
+    SDL_GetRenderDrawColor(renderer,
+                           &prev_color.r,
+                           &prev_color.g,
+                           &prev_color.b,
+                           &prev_color.a);
+
+    SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
+
+    for (size_t i = 0; i != CELL_COUNT; ++i)
+    {
+        for (size_t j = 0; j != CELL_COUNT; ++j)
+        {
+            if (get_cell(u, i, j))
+            {
+                SDL_Rect rect =
+                {
+                    .x = j * CELL_WIDTH + BORDER_WIDTH,
+                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
+                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
+                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
+                };
+
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer,
+                           prev_color.r,
+                           prev_color.g,
+                           prev_color.b,
+                           prev_color.a);
+}
+
+///////////////////////////////////////////////////////////
+/// Threads
+///////////////////////////////////////////////////////////
+// Contains all information needed by a single thread to run.
+typedef struct
+{
+    universe* u;
+    size_t tile_begin;
+    size_t tile_end;
+    kernel_scratch scratch;
+
+    // Synchronization vars
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+} thread_params;
+
+void
+update_tiles(thread_params* args)
+{
+    for (size_t tile = args->tile_begin; tile != args->tile_end; ++tile)
+        step_tile(args->u, tile, &args->scratch);
+}
+
+void*
+thread_execution(void* params)
+{
+    thread_params* args = (thread_params*)params;
+    size_t seen = 0;
+    while (true)
+    {
+        pthread_mutex_lock(args->cv_mtx);
+        while (atomic_load_explicit(args->running, memory_order_relaxed) &&
+               atomic_load_explicit(args->generation, memory_order_relaxed) == seen)
+        {
+            pthread_cond_wait(args->cv, args->cv_mtx);
+        }
+        pthread_mutex_unlock(args->cv_mtx);
+
+        if (!atomic_load_explicit(args->running, memory_order_relaxed))
+            break;
+
+        seen = atomic_load_explicit(args->generation, memory_order_acquire);
+        update_tiles(args);
+
+        atomic_fetch_add_explicit(args->signal, 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Holds all variables that needs to be deallocated,
+// and that is used to communicate between threads.
+typedef struct
+{
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    pthread_t* threads;
+    thread_params* params;
+} thread_info;
+
+thread_info
+create_threads(universe* u)
+{
+    thread_info info =
+    {
+        .running = malloc(sizeof(atomic_bool)),
+        .generation = malloc(sizeof(atomic_size_t)),
+        .signal = malloc(sizeof(atomic_int)),
+        .cv = malloc(sizeof(pthread_cond_t)),
+        .cv_mtx = malloc(sizeof(pthread_mutex_t)),
+        .threads = malloc((THREAD_COUNT - 1) * sizeof(pthread_t)),
+        .params = malloc((THREAD_COUNT) * sizeof(thread_params)),
+    };
+
+    atomic_init(info.running, true);
+    atomic_init(info.generation, 0);
+    atomic_init(info.signal, 0);
+    pthread_cond_init(info.cv, NULL);
+    pthread_mutex_init(info.cv_mtx, NULL);
+
+    // Initialize threads and start execution
+    const size_t tile_count = u->tile_rows * u->tile_cols;
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        info.params[i].u = u;
+        info.params[i].tile_begin = (tile_count * i) / THREAD_COUNT;
+        info.params[i].tile_end = (tile_count * (i + 1)) / THREAD_COUNT;
+        info.params[i].scratch = create_scratch();
+        info.params[i].running = info.running;
+        info.params[i].generation = info.generation;
+        info.params[i].signal = info.signal;
+        info.params[i].cv = info.cv;
+        info.params[i].cv_mtx = info.cv_mtx;
+    }
+
+    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
+        pthread_create(&info.threads[i], NULL, thread_execution, &info.params[i + 1]);
+
+    return info;
+}
+
+void
+destroy_threads(thread_info* info)
+{
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_store_explicit(info->running, false, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    for (size_t i = 0; i < THREAD_COUNT - 1; ++i)
+        pthread_join(info->threads[i], NULL);
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        destroy_scratch(&info->params[i].scratch);
+
+    pthread_cond_destroy(info->cv);
+    pthread_mutex_destroy(info->cv_mtx);
+    free(info->running);
+    free(info->generation);
+    free(info->signal);
+    free(info->cv);
+    free(info->cv_mtx);
+    free(info->threads);
+    free(info->params);
+}
+
+void
+update_grid(thread_info* info,
+            universe* u)
+{
+    // Awake all threads
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_fetch_add_explicit(info->generation, 1, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    update_tiles(&info->params[0]);
+
+    int expected = THREAD_COUNT - 1;
+    while (!atomic_compare_exchange_weak_explicit(info->signal,
+                                                  &expected,
+                                                  0,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+    {
+        expected = THREAD_COUNT - 1;
+    }
+
+    u->current = 1 - u->current;
+}
+
+///////////////////////////////////////////////////////////
+/// Benchmark
+///////////////////////////////////////////////////////////
+double
+get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void
+print_universe_stats(const universe* u,
+                     const char* name,
+                     const double seconds,
+                     const size_t generations)
+{
+    size_t types[4] = {0};
+    size_t bytes = 0;
+    for (size_t i = 0; i != u->tile_rows * u->tile_cols; ++i)
+    {
+        const container* c = &u->tiles[u->current][i];
+        ++types[c->type];
+        bytes += get_container_bytes(c);
+    }
+
+    const double cells = (double)u->tile_rows * u->tile_cols * TILE_CELLS * generations;
+    printf("%-10s %.3f s, %.3f ns/cell, %zu KiB in "
+           "%zu empty, %zu array, %zu bitmap, %zu run tiles\n",
+           name, seconds, seconds * 1e9 / cells, bytes / 1024,
+           types[CONTAINER_EMPTY], types[CONTAINER_ARRAY],
+           types[CONTAINER_BITMAP], types[CONTAINER_RUN]);
+}
+
+// Seeds square clusters of random cells, one every few tiles, over an
+// otherwise empty universe, then steps it with both container policies.
+int
+run_benchmark(int argc,
+              char** argv)
+{
+    const size_t tiles = (argc > 2) ? strtoul(argv[2], NULL, 10) : 16;
+    const size_t density = (argc > 3) ? strtoul(argv[3], NULL, 10) : 300;
+    const size_t generations = (argc > 4) ? strtoul(argv[4], NULL, 10) : 200;
+
+    universe adaptive = create_universe(tiles, tiles, true);
+    universe bitmaps = create_universe(tiles, tiles, false);
+
+    srand(1);
+    uint64_t* bits[2] = {malloc(BITMAP_BYTES), malloc(BITMAP_BYTES)};
+    for (size_t t = 0; t != tiles * tiles; ++t)
+    {
+        if (rand() % 4 != 0)
+            continue;
+
+        memset(bits[0], 0, BITMAP_BYTES);
+        const size_t size = 32 + rand() % 96;
+        const size_t top = rand() % (TILE_SIZE - size);
+        const size_t left = rand() % (TILE_SIZE - size);
+        for (size_t y = top; y != top + size; ++y)
+        {
+            for (size_t x = left; x != left + size; ++x)
+            {
+                if ((size_t)(rand() % 1000) < density)
+                    bits[0][(y * TILE_SIZE + x) / 64] |= 1ULL << (x % 64);
+            }
+        }
+
+        adaptive.tiles[0][t] = container_from_bitmap(bits[0], true);
+        bitmaps.tiles[0][t] = container_from_bitmap(bits[0], false);
+    }
+
+    printf("%zu x %zu cells, %zu generations\n",
+           tiles * TILE_SIZE, tiles * TILE_SIZE, generations);
+
+    universe* universes[2] = {&adaptive, &bitmaps};
+    const char* names[2] = {"adaptive:", "bitmaps:"};
+    for (size_t i = 0; i != 2; ++i)
+    {
+        thread_info threads = create_threads(universes[i]);
+        const double start = get_seconds();
+        for (size_t gen = 0; gen != generations; ++gen)
+            update_grid(&threads, universes[i]);
+        const double seconds = get_seconds() - start;
+        destroy_threads(&threads);
+
+        print_universe_stats(universes[i], names[i], seconds, generations);
+    }
+
+    bool same = true;
+    for (size_t t = 0; t != tiles * tiles; ++t)
+    {
+        container_to_bitmap(&adaptive.tiles[adaptive.current][t], bits[0]);
+        container_to_bitmap(&bitmaps.tiles[bitmaps.current][t], bits[1]);
+        same &= memcmp(bits[0], bits[1], BITMAP_BYTES) == 0;
+    }
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    free(bits[0]);
+    free(bits[1]);
+    destroy_universe(&adaptive);
+    destroy_universe(&bitmaps);
+    return same ? 0 : 1;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return run_benchmark(argc, argv);
+
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    if (!sdl_init(&window, &renderer, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return 1;
+
+    universe u = create_universe(1, 1, true);
+
+    // Set an initial state
+    uint64_t* bits = calloc(BITMAP_WORDS, sizeof(uint64_t));
+    for (size_t i = 0; i != CELL_COUNT; ++i)
+    {
+        for (size_t j = 0; j != CELL_COUNT; ++j)
+        {
+            if ((i + 1) % 2 == 0)
+                bits[(i * TILE_SIZE + j) / 64] |= 1ULL << (j % 64);
+        }
+    }
+    u.tiles[0][0] = container_from_bitmap(bits, true);
+    free(bits);
+
+    thread_info threads = create_threads(&u);
+
+    bool should_continue = true;
+    bool iterate = false;
+    while (should_continue)
+    {
+        should_continue = handle_events(&u, &iterate);
+
+        if (iterate)
+            update_grid(&threads, &u);
+
+        SDL_RenderClear(renderer);
+        draw_grid(&u, renderer);
+
+        SDL_RenderPresent(renderer);
+
+        SDL_Delay(60);
+    }
+
+    destroy_threads(&threads);
+    destroy_universe(&u);
+
+    sdl_shutdown(window, renderer);
+
+    return 0;
+}
@@ -0,0 +1,2954 @@
+///////////////////////////////////////////////////////////
+/// Interleaved state planes.
+/// Line of thought:
+/// - Layout:
+///     Cells are packed 64 to a word, and every word of the
+///     grid is stored next to the word holding the same cells
+///     in the other generation: (plane 0, plane 1) pairs.
+///     A generation reads one plane and writes the other,
+///     so reading a word and writing its next state touch
+///     the same cache line, and there is nothing to copy or
+///     swap between generations, only the plane index flips.
+/// - Bounds checking:
+///     Like the other solutions there is a dead border around
+///     the grid, one row above and below, and one column on
+///     each side in the first and last word of every row.
+/// - Fixed widths:
+///     Sizes are chosen at runtime, but rows of 64, 128, 256,
+///     512 or 1024 bits (borders included) get a kernel of
+///     their own with the word loop unrolled, so small
+///     universes keep the speed of compile-time sizes.
+/// - Threads:
+///     Bands of rows never write anything another band reads,
+///     so they only meet once per generation.
+///     Workers wait for a new generation number instead of
+///     a bare signal, so a broadcast cannot be missed.
+/// - Many generations at once:
+///     The two planes are all a space-time recursion needs,
+///     generation t lives in plane (plane + t) % 2.
+///     Trapezoids of rows x generations are cut in space
+///     while they are wide and in time while they are tall
+///     (Frigo and Strumpen), so every level of the cache
+///     gets reused without knowing its size.
+///     Each thread walks an upright trapezoid over its band,
+///     then the inverted trapezoids between bands fill in.
+/// - Memoization:
+///     Repetitive regions (agar, wicks, guns) keep producing
+///     the same tiles. Stepping MEMO_GENERATIONS at a time,
+///     the core of a tile is looked up by the window around
+///     it, chaotic tiles are stepped directly instead.
+/// - Hybrid:
+///     Soup early, ash later, oscillators forever favour
+///     different engines. Every HYBRID_SAMPLE updates two
+///     generations are stepped row by row to measure density,
+///     changed words and period. A period of 1 or 2 is already
+///     held by the two planes, few changed words go to a sparse
+///     engine stepping only their neighbourhood. Otherwise
+///     the engine measured cheapest runs, dense, sparse or
+///     the tile memo.
+/// - Light cone:
+///     A region n generations ahead depends only on the region
+///     grown by n cells on each side. That window is copied
+///     out and stepped, a row shorter on each cut side every
+///     generation, without advancing the grid itself.
+/// - Rule maps:
+///     Regions of one grid can follow different rules, a map
+///     gives the rule of every tile of RULE_TILE rows by one
+///     word. Runs of tiles sharing a rule are stepped by one
+///     call of that rule's kernel, a cell on a tile edge
+///     follows its own tile's rule.
+/// - Other rules:
+///     Any B/S rule runs through a generic kernel that matches
+///     the bit-sliced neighbour count against every count the
+///     rule lists. For speed, C source for a kernel with the
+///     rule minimized to a single boolean expression over the
+///     count bits is written, compiled with the local compiler
+///     into a shared object cached by the hash of its source,
+///     and loaded with dlopen. Without a compiler the generic
+///     kernel stays. Life itself keeps the hand-written kernel.
+///
+/// Benchmark:
+///     ./interleaved_buffer bench [rows] [cols] [generations] [soup|stripes]
+///     runs the same kernel over the interleaved grid,
+///     over two separate grids swapped each generation,
+///     and over two separate grids copied each generation
+///     (like double_buffer.c), and with the space-time
+///     recursion and the tile memo, and checks they all agree.
+///     ./interleaved_buffer bench_rule <rule> [rows] [cols] [generations]
+///     runs the generic and the generated kernel for a rule
+///     such as B36/S23, and checks they agree.
+///     ./interleaved_buffer rule <rule> opens the window with it.
+///     ./interleaved_buffer bench_hybrid [rows] [cols] [generations]
+///     runs a soup, then pulsars and a block starting on the
+///     tile memo, then the soup with other engines stepping in
+///     between, through the hybrid and the dense engine.
+///     ./interleaved_buffer bench_cone [rows] [cols] [generations] [size]
+///     computes the center of a soup generations ahead through
+///     its light cone and by advancing the whole grid.
+///     ./interleaved_buffer bench_rule_map [rows] [cols] [generations] <rule>...
+///     steps a soup on tiles following the rules at random through
+///     every engine, checks them cell by cell, and times the whole
+///     grid under the first rule.
+///////////////////////////////////////////////////////////
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+#define BORDER_WIDTH 1
+#define CELL_WIDTH 10
+#define CELL_HEIGHT 10
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 800
+#define CELL_COUNT (WINDOW_WIDTH / CELL_WIDTH)
+#define THREAD_COUNT 4
+#define TIME_BLOCK 16
+#define MEMO_TILE 16
+#define MEMO_GENERATIONS 8
+#define MEMO_WINDOW (MEMO_TILE + 2 * MEMO_GENERATIONS)
+#define MEMO_TABLE_SIZE (1 << 14)
+#define MEMO_MISS_LIMIT 4
+#define MEMO_RETRY 16
+#define RULE_CACHE_DIR "rule_cache"
+#define RULE_TILE 64
+#define RULE_MAP_SIZE 16
+#define HYBRID_SAMPLE 8
+#define HYBRID_SAMPLE_GENERATIONS 2
+#define HYBRID_PROBE 8
+#define HYBRID_SPARSE_ACTIVITY 0.5
+#define HYBRID_MEMO_DENSITY 0.2
+#define HYBRID_MARGIN 1.25
+
+int
+sdl_init(SDL_Window** out_window,
+         SDL_Renderer** out_renderer,
+         const int window_width,
+         const int window_height)
+{
+    (*out_window) = NULL;
+    (*out_renderer) = NULL;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        goto failure;
+    }
+
+    (*out_window) = SDL_CreateWindow("interleaved_conways",
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     window_width,
+                                     window_height,
+                                     SDL_WINDOW_SHOWN);
+
+    if ((*out_window) == NULL)
+    {
+        goto failure;
+    }
+
+    (*out_renderer) = SDL_CreateRenderer((*out_window),
+                                         -1,
+                                         SDL_RENDERER_ACCELERATED);
+
+    if ((*out_renderer) == NULL)
+    {
+        goto failure;
+    }
+
+    return 1;
+
+failure:
+    fprintf(stderr, "SDL_Error: %s\n", SDL_GetError());
+    SDL_DestroyRenderer((*out_renderer));
+    SDL_DestroyWindow((*out_window));
+    return 0;
+}
+
+void
+sdl_shutdown(SDL_Window* window,
+             SDL_Renderer* renderer)
+{
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+///////////////////////////////////////////////////////////
+/// Rules
+///////////////////////////////////////////////////////////
+// Bit n is set if a cell with n neighbours is born / survives.
+typedef struct life_rule
+{
+    uint16_t birth;
+    uint16_t survive;
+} life_rule;
+
+// Steps words [word_begin, word_end) of rows [row_begin, row_end) from
+// src to dst, see sub_update. Generated kernels have their rule built in
+// and ignore the last argument.
+typedef void (*rule_kernel)(uint64_t* restrict dst,
+                            const uint64_t* restrict src,
+                            const size_t stride,
+                            const size_t row_begin,
+                            const size_t row_end,
+                            const size_t word_begin,
+                            const size_t word_end,
+                            const size_t row_words,
+                            const size_t cols,
+                            const life_rule* rule);
+
+// Reads a rule such as "B3/S23" or "b36/s23".
+bool
+parse_rule(const char* text,
+           life_rule* out)
+{
+    life_rule rule = { 0, 0 };
+    uint16_t* counts = NULL;
+
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        if (*c == 'B' || *c == 'b')
+            counts = &rule.birth;
+        else if (*c == 'S' || *c == 's')
+            counts = &rule.survive;
+        else if (*c >= '0' && *c <= '8' && counts != NULL)
+            (*counts) |= 1U << (*c - '0');
+        else if (*c != '/')
+            return false;
+    }
+
+    (*out) = rule;
+    return true;
+}
+
+bool
+is_life_rule(const life_rule* rule)
+{
+    return rule->birth == (1U << 3) && rule->survive == ((1U << 2) | (1U << 3));
+}
+
+// Rule of every tile of a grid, a tile is RULE_TILE rows of one word
+// (64 columns, counting the border column). Id i is rules[i].
+typedef struct
+{
+    size_t tile_rows;
+    size_t tile_cols;
+    uint8_t* ids;
+
+    size_t rule_count;
+    life_rule rules[RULE_MAP_SIZE];
+    rule_kernel kernels[RULE_MAP_SIZE];
+    void* libraries[RULE_MAP_SIZE];
+} rule_map;
+
+///////////////////////////////////////////////////////////
+/// Grid
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    // (rows + 2) * row_words pairs of words, the two planes of a pair
+    // are adjacent. Column c is bit (c + 1) % 64 of word (c + 1) / 64.
+    uint64_t* words;
+    size_t rows;
+    size_t cols;
+    size_t row_words;
+    // Plane holding the current generation
+    size_t plane;
+    // Kernel for any rule but Life, NULL runs sub_update. Generated
+    // kernels keep their shared object open until the grid is destroyed.
+    life_rule rule;
+    rule_kernel kernel;
+    void* kernel_library;
+    // Rule of every tile, NULL if the whole grid follows rule. A window
+    // cut out of a bigger grid finds its tiles from map_row, map_word on.
+    const rule_map* rule_map;
+    size_t map_row;
+    size_t map_word;
+} grid;
+
+size_t
+get_word_idx(const grid* g,
+             const int row,
+             const int col)
+{
+    return (size_t)(row + 1) * g->row_words + (size_t)(col + 1) / 64;
+}
+
+bool
+get_cell(const grid* g,
+         const int row,
+         const int col)
+{
+    const uint64_t word = g->words[get_word_idx(g, row, col) * 2 + g->plane];
+    return (word >> ((col + 1) % 64)) & 1;
+}
+
+void
+set_cell(grid* g,
+         const int row,
+         const int col,
+         const bool val)
+{
+    uint64_t* word = &g->words[get_word_idx(g, row, col) * 2 + g->plane];
+    const uint64_t bit = 1ULL << ((col + 1) % 64);
+
+    if (val)
+        (*word) |= bit;
+    else
+        (*word) &= ~bit;
+}
+
+grid
+create_grid(const size_t rows,
+            const size_t cols)
+{
+    // Creating an outer layer for the grid,
+    // allowing us to drop the bounds checking.
+    grid g =
+    {
+        .rows = rows,
+        .cols = cols,
+        .row_words = (cols + 2 + 63) / 64,
+        .plane = 0,
+        .rule = { .birth = 1U << 3, .survive = (1U << 2) | (1U << 3) },
+        .kernel = NULL,
+        .kernel_library = NULL,
+        .rule_map = NULL,
+        .map_row = 0,
+        .map_word = 0,
+    };
+    g.words = calloc((rows + 2) * g.row_words * 2, sizeof(uint64_t));
+
+    // Set an initial state
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&g, i, j, (i + 1) % 2 == 0);
+
+    return g;
+}
+
+void
+destroy_grid(grid* g)
+{
+    free(g->words);
+    g->words = NULL;
+
+    if (g->kernel_library != NULL)
+        dlclose(g->kernel_library);
+    g->kernel_library = NULL;
+}
+
+// Only the inner columns may come alive, the border stays dead.
+uint64_t
+get_word_mask(const size_t cols,
+              const size_t word)
+{
+    const size_t first = word * 64;
+    const size_t begin = (first < 1) ? 1 - first : 0;
+    const size_t end = (cols + 1 < first + 64) ? cols + 1 - first : 64;
+
+    const uint64_t below_end = (end == 64) ? ~0ULL : (1ULL << end) - 1;
+    return below_end & ~((1ULL << begin) - 1);
+}
+
+// Next state of 64 cells at once, given the 8 words of their
+// neighbours (already shifted into place) and their current state.
+// The neighbour counts are summed bit-sliced through an adder tree,
+// a cell lives if the count is 3, or 2 and it is already alive.
+uint64_t
+life_rule_word(const uint64_t neighbors[8],
+               const uint64_t alive)
+{
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t ones = d_xor ^ c_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t twos = e_sum ^ d_carry;
+    const uint64_t f_carry = e_sum & d_carry;
+
+    return twos & ~(e_carry | f_carry) & (ones | alive);
+}
+
+// Steps rows [row_begin, row_end) from src to dst.
+// Word w of a row is at index w * stride, so the same kernel runs on
+// the interleaved planes (stride 2) and on separate grids (stride 1).
+void
+sub_update(uint64_t* restrict dst,
+           const uint64_t* restrict src,
+           const size_t stride,
+           const size_t row_begin,
+           const size_t row_end,
+           const size_t row_words,
+           const size_t cols)
+{
+    // Rules from: https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+    // Any live cell with fewer than two live neighbours dies, as if caused by underpopulation.
+    // Any live cell with two or three live neighbours lives on to the next generation.
+    // Any live cell with more than three live neighbours dies, as if by overpopulation.
+    // Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
+    for (size_t i = row_begin; i != row_end; ++i)
+    {
+        const uint64_t* above = &src[(i + 0) * row_words * stride];
+        const uint64_t* curr = &src[(i + 1) * row_words * stride];
+        const uint64_t* below = &src[(i + 2) * row_words * stride];
+        uint64_t* out = &dst[(i + 1) * row_words * stride];
+
+        for (size_t w = 0; w != row_words; ++w)
+        {
+            const size_t idx = w * stride;
+            const size_t prev_idx = (w != 0) ? idx - stride : idx;
+            const size_t next_idx = (w + 1 != row_words) ? idx + stride : idx;
+            const uint64_t first = (w != 0);
+            const uint64_t last = (w + 1 != row_words);
+
+            // Bit n of west holds column n - 1, bit n of east column n + 1
+            const uint64_t neighbors[8] =
+            {
+                (above[idx] << 1) | ((above[prev_idx] >> 63) & first),
+                above[idx],
+                (above[idx] >> 1) | ((above[next_idx] << 63) & (last << 63)),
+                (curr[idx] << 1) | ((curr[prev_idx] >> 63) & first),
+                (curr[idx] >> 1) | ((curr[next_idx] << 63) & (last << 63)),
+                (below[idx] << 1) | ((below[prev_idx] >> 63) & first),
+                below[idx],
+                (below[idx] >> 1) | ((below[next_idx] << 63) & (last << 63)),
+            };
+
+            out[idx] = life_rule_word(neighbors, curr[idx]) & get_word_mask(cols, w);
+        }
+    }
+}
+
+// Defines sub_update_fixed_<BITS>, sub_update over the interleaved
+// planes for rows of exactly BITS / 64 words. The word count is a
+// constant, so the word loop unrolls fully and the edge words of a row
+// lose their branches, like the compile-time sizes of the other programs.
+#define DEFINE_FIXED_UPDATE(BITS)                                                       \
+void                                                                                    \
+sub_update_fixed_##BITS(uint64_t* restrict dst,                                         \
+                        const uint64_t* restrict src,                                   \
+                        const size_t row_begin,                                         \
+                        const size_t row_end,                                           \
+                        const size_t cols)                                              \
+{                                                                                       \
+    const size_t row_words = BITS / 64;                                                 \
+    uint64_t masks[BITS / 64];                                                          \
+    for (size_t w = 0; w != row_words; ++w)                                             \
+        masks[w] = get_word_mask(cols, w);                                              \
+                                                                                        \
+    for (size_t i = row_begin; i != row_end; ++i)                                       \
+    {                                                                                   \
+        const uint64_t* above = &src[(i + 0) * row_words * 2];                          \
+        const uint64_t* curr = &src[(i + 1) * row_words * 2];                           \
+        const uint64_t* below = &src[(i + 2) * row_words * 2];                          \
+        uint64_t* out = &dst[(i + 1) * row_words * 2];                                  \
+                                                                                        \
+        _Pragma("GCC unroll 16")                                                        \
+        for (size_t w = 0; w != row_words; ++w)                                         \
+        {                                                                               \
+            const size_t idx = w * 2;                                                   \
+            const size_t prev_idx = (w != 0) ? idx - 2 : idx;                           \
+            const size_t next_idx = (w + 1 != row_words) ? idx + 2 : idx;               \
+            const uint64_t first = (w != 0);                                            \
+            const uint64_t last = (w + 1 != row_words);                                 \
+                                                                                        \
+            const uint64_t neighbors[8] =                                               \
+            {                                                                           \
+                (above[idx] << 1) | ((above[prev_idx] >> 63) & first),                  \
+                above[idx],                                                             \
+                (above[idx] >> 1) | ((above[next_idx] << 63) & (last << 63)),           \
+                (curr[idx] << 1) | ((curr[prev_idx] >> 63) & first),                    \
+                (curr[idx] >> 1) | ((curr[next_idx] << 63) & (last << 63)),             \
+                (below[idx] << 1) | ((below[prev_idx] >> 63) & first),                  \
+                below[idx],                                                             \
+                (below[idx] >> 1) | ((below[next_idx] << 63) & (last << 63)),           \
+            };                                                                          \
+                                                                                        \
+            out[idx] = life_rule_word(neighbors, curr[idx]) & masks[w];                 \
+        }                                                                               \
+    }                                                                                   \
+}
+
+DEFINE_FIXED_UPDATE(64)
+DEFINE_FIXED_UPDATE(128)
+DEFINE_FIXED_UPDATE(256)
+DEFINE_FIXED_UPDATE(512)
+DEFINE_FIXED_UPDATE(1024)
+
+// Runs the specialization for the row width, if there is one.
+bool
+sub_update_fixed(uint64_t* restrict dst,
+                 const uint64_t* restrict src,
+                 const size_t row_begin,
+                 const size_t row_end,
+                 const size_t row_words,
+                 const size_t cols)
+{
+    switch (row_words)
+    {
+    case 1: sub_update_fixed_64(dst, src, row_begin, row_end, cols); return true;
+    case 2: sub_update_fixed_128(dst, src, row_begin, row_end, cols); return true;
+    case 4: sub_update_fixed_256(dst, src, row_begin, row_end, cols); return true;
+    case 8: sub_update_fixed_512(dst, src, row_begin, row_end, cols); return true;
+    case 16: sub_update_fixed_1024(dst, src, row_begin, row_end, cols); return true;
+    default: return false;
+    }
+}
+
+// Bit n of counts[0..3] holds bit 0..3 of the neighbour count of
+// cell n, through the same adder tree as life_rule_word.
+void
+count_neighbors(const uint64_t neighbors[8],
+                uint64_t counts[4])
+{
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t f_carry = e_sum & d_carry;
+
+    counts[0] = d_xor ^ c_sum;
+    counts[1] = e_sum ^ d_carry;
+    counts[2] = e_carry ^ f_carry;
+    counts[3] = e_carry & f_carry;
+}
+
+// Next state of 64 cells under any rule: the cells whose count
+// matches each count the rule lists are picked out one by one.
+uint64_t
+rule_word(const uint64_t neighbors[8],
+          const uint64_t alive,
+          const life_rule* rule)
+{
+    uint64_t counts[4];
+    count_neighbors(neighbors, counts);
+
+    uint64_t next = 0;
+    for (size_t n = 0; n != 9; ++n)
+    {
+        const uint64_t born = ((rule->birth >> n) & 1) ? ~alive : 0;
+        const uint64_t survives = ((rule->survive >> n) & 1) ? alive : 0;
+        if ((born | survives) == 0)
+            continue;
+
+        uint64_t match = born | survives;
+        for (size_t bit = 0; bit != 4; ++bit)
+            match &= ((n >> bit) & 1) ? counts[bit] : ~counts[bit];
+        next |= match;
+    }
+    return next;
+}
+
+// sub_update under any rule, the fallback when no kernel was generated.
+// Life is tested once, the compiler takes the test out of the loops.
+void
+sub_update_rule(uint64_t* restrict dst,
+                const uint64_t* restrict src,
+                const size_t stride,
+                const size_t row_begin,
+                const size_t row_end,
+                const size_t word_begin,
+                const size_t word_end,
+                const size_t row_words,
+                const size_t cols,
+                const life_rule* rule)
+{
+    const bool life = is_life_rule(rule);
+    for (size_t i = row_begin; i != row_end; ++i)
+    {
+        const uint64_t* above = &src[(i + 0) * row_words * stride];
+        const uint64_t* curr = &src[(i + 1) * row_words * stride];
+        const uint64_t* below = &src[(i + 2) * row_words * stride];
+        uint64_t* out = &dst[(i + 1) * row_words * stride];
+
+        for (size_t w = word_begin; w != word_end; ++w)
+        {
+            const size_t idx = w * stride;
+            const size_t prev_idx = (w != 0) ? idx - stride : idx;
+            const size_t next_idx = (w + 1 != row_words) ? idx + stride : idx;
+            const uint64_t first = (w != 0);
+            const uint64_t last = (w + 1 != row_words);
+
+            const uint64_t neighbors[8] =
+            {
+                (above[idx] << 1) | ((above[prev_idx] >> 63) & first),
+                above[idx],
+                (above[idx] >> 1) | ((above[next_idx] << 63) & (last << 63)),
+                (curr[idx] << 1) | ((curr[prev_idx] >> 63) & first),
+                (curr[idx] >> 1) | ((curr[next_idx] << 63) & (last << 63)),
+                (below[idx] << 1) | ((below[prev_idx] >> 63) & first),
+                below[idx],
+                (below[idx] >> 1) | ((below[next_idx] << 63) & (last << 63)),
+            };
+
+            const uint64_t next = life ? life_rule_word(neighbors, curr[idx])
+                                       : rule_word(neighbors, curr[idx], rule);
+            out[idx] = next & get_word_mask(cols, w);
+        }
+    }
+}
+
+// Steps rows [row_begin, row_end) of a grid with a rule map. Each run of
+// tiles with the same rule in a tile row is one call to its kernel, a
+// cell on a tile edge follows the rule of its own tile.
+void
+step_rows_mapped(const grid* g,
+                 const size_t plane,
+                 const size_t row_begin,
+                 const size_t row_end)
+{
+    const rule_map* map = g->rule_map;
+    size_t row = row_begin;
+    while (row != row_end)
+    {
+        const size_t map_row = g->map_row + row;
+        const size_t tile_end = row + RULE_TILE - map_row % RULE_TILE;
+        const size_t band_end = (tile_end < row_end) ? tile_end : row_end;
+        const uint8_t* ids = &map->ids[(map_row / RULE_TILE) * map->tile_cols + g->map_word];
+
+        size_t w = 0;
+        while (w != g->row_words)
+        {
+            size_t run_end = w + 1;
+            while (run_end != g->row_words && ids[run_end] == ids[w])
+                ++run_end;
+
+            map->kernels[ids[w]](g->words + (1 - plane), g->words + plane, 2,
+                                 row, band_end, w, run_end, g->row_words, g->cols,
+                                 &map->rules[ids[w]]);
+            w = run_end;
+        }
+        row = band_end;
+    }
+}
+
+// Steps rows [row_begin, row_end) of the grid from its current plane.
+void
+step_rows(const grid* g,
+          const size_t plane,
+          const size_t row_begin,
+          const size_t row_end)
+{
+    if (g->rule_map != NULL)
+        step_rows_mapped(g, plane, row_begin, row_end);
+    else if (g->kernel == NULL)
+    {
+        if (!sub_update_fixed(g->words + (1 - plane), g->words + plane,
+                              row_begin, row_end, g->row_words, g->cols))
+            sub_update(g->words + (1 - plane), g->words + plane, 2,
+                       row_begin, row_end, g->row_words, g->cols);
+    }
+    else
+        g->kernel(g->words + (1 - plane), g->words + plane, 2,
+                  row_begin, row_end, 0, g->row_words, g->row_words, g->cols, &g->rule);
+}
+
+///////////////////////////////////////////////////////////
+/// Rule code generation
+///////////////////////////////////////////////////////////
+// A product term over the 5 inputs of a rule: bit 4 is the cell
+// itself, bits 3..0 are the bits of its neighbour count.
+// Inputs outside care are left out of the term.
+typedef struct
+{
+    uint8_t value;
+    uint8_t care;
+} implicant;
+
+// Prime implicants of the rule (Quine-McCluskey), counts 9 to 15
+// cannot happen and may be covered or not. Returns how many.
+size_t
+find_prime_implicants(const life_rule* rule,
+                      implicant primes[243])
+{
+    // At most 3^5 distinct terms
+    implicant terms[2][243];
+    size_t count = 0;
+    size_t prime_count = 0;
+
+    for (size_t input = 0; input != 32; ++input)
+    {
+        const size_t n = input & 15;
+        const uint16_t counts = (input & 16) ? rule->survive : rule->birth;
+        if (n > 8 || ((counts >> n) & 1))
+            terms[0][count++] = (implicant){ .value = input, .care = 31 };
+    }
+
+    for (size_t level = 0; count != 0; level = 1 - level)
+    {
+        const implicant* curr = terms[level];
+        implicant* next = terms[1 - level];
+        bool combined[243] = { false };
+        size_t next_count = 0;
+
+        for (size_t a = 0; a != count; ++a)
+        {
+            for (size_t b = a + 1; b != count; ++b)
+            {
+                const uint8_t diff = curr[a].value ^ curr[b].value;
+                if (curr[a].care != curr[b].care || (diff & (diff - 1)) != 0)
+                    continue;
+
+                combined[a] = combined[b] = true;
+                const implicant merged =
+                {
+                    .value = curr[a].value & ~diff,
+                    .care = curr[a].care & ~diff,
+                };
+
+                bool seen = false;
+                for (size_t k = 0; k != next_count && !seen; ++k)
+                    seen = next[k].value == merged.value && next[k].care == merged.care;
+                if (!seen)
+                    next[next_count++] = merged;
+            }
+        }
+
+        for (size_t a = 0; a != count; ++a)
+            if (!combined[a])
+                primes[prime_count++] = curr[a];
+        count = next_count;
+    }
+
+    return prime_count;
+}
+
+// Writes the rule as a sum of products over the words alive, ones,
+// twos, fours and eights. Primes are picked greedily, the one
+// covering the most cells the rule needs left first.
+void
+write_rule_expression(FILE* out,
+                      const life_rule* rule)
+{
+    implicant primes[243];
+    const size_t prime_count = find_prime_implicants(rule, primes);
+    const char* names[5] = { "ones", "twos", "fours", "eights", "alive" };
+
+    uint32_t uncovered = 0;
+    for (size_t input = 0; input != 32; ++input)
+    {
+        const size_t n = input & 15;
+        const uint16_t counts = (input & 16) ? rule->survive : rule->birth;
+        if (n <= 8 && ((counts >> n) & 1))
+            uncovered |= 1U << input;
+    }
+
+    if (uncovered == 0)
+        fputs("0", out);
+
+    bool first_term = true;
+    while (uncovered != 0)
+    {
+        size_t best = 0;
+        int best_count = -1;
+        uint32_t best_cover = 0;
+        for (size_t p = 0; p != prime_count; ++p)
+        {
+            uint32_t cover = 0;
+            for (size_t input = 0; input != 32; ++input)
+                if ((input & primes[p].care) == primes[p].value)
+                    cover |= 1U << input;
+
+            const int cover_count = __builtin_popcount(cover & uncovered);
+            if (cover_count > best_count)
+            {
+                best = p;
+                best_count = cover_count;
+                best_cover = cover;
+            }
+        }
+        uncovered &= ~best_cover;
+
+        fputs(first_term ? "(" : " | (", out);
+        first_term = false;
+
+        if (primes[best].care == 0)
+            fputs("~0ULL", out);
+
+        bool first_literal = true;
+        for (size_t input = 5; input-- != 0;)
+        {
+            if (((primes[best].care >> input) & 1) == 0)
+                continue;
+
+            fprintf(out, "%s%s%s", first_literal ? "" : " & ",
+                    ((primes[best].value >> input) & 1) ? "" : "~", names[input]);
+            first_literal = false;
+        }
+        fputs(")", out);
+    }
+}
+
+// The loop of sub_update_rule with the rule expression pasted in.
+const char* generated_kernel_head =
+    "#include <stddef.h>\n"
+    "#include <stdint.h>\n"
+    "\n"
+    "struct life_rule;\n"
+    "\n"
+    "void\n"
+    "generated_kernel(uint64_t* restrict dst,\n"
+    "                 const uint64_t* restrict src,\n"
+    "                 const size_t stride,\n"
+    "                 const size_t row_begin,\n"
+    "                 const size_t row_end,\n"
+    "                 const size_t word_begin,\n"
+    "                 const size_t word_end,\n"
+    "                 const size_t row_words,\n"
+    "                 const size_t cols,\n"
+    "                 const struct life_rule* rule)\n"
+    "{\n"
+    "    (void)rule;\n"
+    "    for (size_t i = row_begin; i != row_end; ++i)\n"
+    "    {\n"
+    "        const uint64_t* above = &src[(i + 0) * row_words * stride];\n"
+    "        const uint64_t* curr = &src[(i + 1) * row_words * stride];\n"
+    "        const uint64_t* below = &src[(i + 2) * row_words * stride];\n"
+    "        uint64_t* out = &dst[(i + 1) * row_words * stride];\n"
+    "\n"
+    "        for (size_t w = word_begin; w != word_end; ++w)\n"
+    "        {\n"
+    "            const size_t idx = w * stride;\n"
+    "            const size_t prev_idx = (w != 0) ? idx - stride : idx;\n"
+    "            const size_t next_idx = (w + 1 != row_words) ? idx + stride : idx;\n"
+    "            const uint64_t first = (w != 0);\n"
+    "            const uint64_t last = (w + 1 != row_words);\n"
+    "\n"
+    "            const uint64_t n0 = (above[idx] << 1) | ((above[prev_idx] >> 63) & first);\n"
+    "            const uint64_t n1 = above[idx];\n"
+    "            const uint64_t n2 = (above[idx] >> 1) | ((above[next_idx] << 63) & (last << 63));\n"
+    "            const uint64_t n3 = (curr[idx] << 1) | ((curr[prev_idx] >> 63) & first);\n"
+    "            const uint64_t n4 = (curr[idx] >> 1) | ((curr[next_idx] << 63) & (last << 63));\n"
+    "            const uint64_t n5 = (below[idx] << 1) | ((below[prev_idx] >> 63) & first);\n"
+    "            const uint64_t n6 = below[idx];\n"
+    "            const uint64_t n7 = (below[idx] >> 1) | ((below[next_idx] << 63) & (last << 63));\n"
+    "\n"
+    "            const uint64_t a_xor = n0 ^ n1;\n"
+    "            const uint64_t a_sum = a_xor ^ n2;\n"
+    "            const uint64_t a_carry = (n0 & n1) | (a_xor & n2);\n"
+    "            const uint64_t b_xor = n3 ^ n4;\n"
+    "            const uint64_t b_sum = b_xor ^ n5;\n"
+    "            const uint64_t b_carry = (n3 & n4) | (b_xor & n5);\n"
+    "            const uint64_t c_sum = n6 ^ n7;\n"
+    "            const uint64_t c_carry = n6 & n7;\n"
+    "            const uint64_t d_xor = a_sum ^ b_sum;\n"
+    "            const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);\n"
+    "            const uint64_t e_xor = a_carry ^ b_carry;\n"
+    "            const uint64_t e_sum = e_xor ^ c_carry;\n"
+    "            const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);\n"
+    "            const uint64_t f_carry = e_sum & d_carry;\n"
+    "\n"
+    "            const uint64_t alive = curr[idx];\n"
+    "            const uint64_t ones = d_xor ^ c_sum;\n"
+    "            const uint64_t twos = e_sum ^ d_carry;\n"
+    "            const uint64_t fours = e_carry ^ f_carry;\n"
+    "            const uint64_t eights = e_carry & f_carry;\n"
+    "            (void)alive; (void)ones; (void)twos; (void)fours; (void)eights;\n"
+    "\n"
+    "            const size_t bit_first = w * 64;\n"
+    "            const size_t bit_begin = (bit_first < 1) ? 1 - bit_first : 0;\n"
+    "            const size_t bit_end = (cols + 1 < bit_first + 64) ? cols + 1 - bit_first : 64;\n"
+    "            const uint64_t below_end = (bit_end == 64) ? ~0ULL : (1ULL << bit_end) - 1;\n"
+    "            const uint64_t mask = below_end & ~((1ULL << bit_begin) - 1);\n"
+    "\n"
+    "            out[idx] = mask & (";
+
+const char* generated_kernel_tail =
+    ");\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// FNV-1a
+uint64_t
+hash_text(const char* text,
+          const size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i != length; ++i)
+    {
+        hash ^= (uint8_t)text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Returns the kernel for the rule: NULL for Life, a kernel compiled for
+// the rule (or loaded from the cache) if the compiler is there, and
+// sub_update_rule otherwise. A loaded library is returned through library.
+rule_kernel
+load_rule_kernel(const life_rule* rule,
+                 void** library)
+{
+    (*library) = NULL;
+    if (is_life_rule(rule))
+        return NULL;
+
+    const char* compiler = getenv("CC");
+    if (compiler == NULL || compiler[0] == '\0')
+        compiler = "cc";
+    const char* flags = "-std=c11 -O3 -march=native -shared -fPIC";
+
+    // The source and the command that builds it decide the cache entry
+    char* source = NULL;
+    size_t source_length = 0;
+    FILE* stream = open_memstream(&source, &source_length);
+    if (stream == NULL)
+        return sub_update_rule;
+    fprintf(stream, "// %s %s\n", compiler, flags);
+    fputs(generated_kernel_head, stream);
+    write_rule_expression(stream, rule);
+    fputs(generated_kernel_tail, stream);
+    fclose(stream);
+
+    char source_path[256];
+    char library_path[256];
+    const unsigned long long hash = hash_text(source, source_length);
+    snprintf(source_path, sizeof(source_path), "%s/rule_%016llx.c", RULE_CACHE_DIR, hash);
+    snprintf(library_path, sizeof(library_path), "%s/rule_%016llx.so", RULE_CACHE_DIR, hash);
+
+    struct stat cached;
+    if (stat(library_path, &cached) != 0)
+    {
+        mkdir(RULE_CACHE_DIR, 0755);
+        FILE* file = fopen(source_path, "w");
+        const bool written = file != NULL &&
+                             fwrite(source, 1, source_length, file) == source_length;
+        if (file != NULL)
+            fclose(file);
+
+        // Built under a temporary name, so a concurrent run never
+        // loads a half written library
+        char command[2048];
+        const int command_length =
+            snprintf(command, sizeof(command), "%s %s -o %s.tmp %s 2>/dev/null && mv %s.tmp %s",
+                     compiler, flags, library_path, source_path, library_path, library_path);
+
+        if (!written || command_length < 0 || (size_t)command_length >= sizeof(command) ||
+            system(command) != 0)
+        {
+            fprintf(stderr, "Could not compile %s, using the generic rule kernel\n", source_path);
+            free(source);
+            return sub_update_rule;
+        }
+    }
+    free(source);
+
+    (*library) = dlopen(library_path, RTLD_NOW | RTLD_LOCAL);
+    rule_kernel kernel = ((*library) != NULL) ? (rule_kernel)dlsym((*library), "generated_kernel") : NULL;
+    if (kernel == NULL)
+    {
+        fprintf(stderr, "Could not load %s, using the generic rule kernel\n", library_path);
+        if ((*library) != NULL)
+            dlclose((*library));
+        (*library) = NULL;
+        return sub_update_rule;
+    }
+
+    return kernel;
+}
+
+// Switches the grid to the rule, dropping the previous kernel.
+void
+set_grid_rule(grid* g,
+              const life_rule* rule)
+{
+    if (g->kernel_library != NULL)
+        dlclose(g->kernel_library);
+
+    g->rule = (*rule);
+    g->kernel = load_rule_kernel(rule, &g->kernel_library);
+}
+
+///////////////////////////////////////////////////////////
+/// Rule maps
+///////////////////////////////////////////////////////////
+// Returns the id of the rule in the map, loading its kernel the first
+// time it is added, or -1 if the map is full. Life runs through
+// sub_update_rule, the hand-written kernel cannot step part of a row.
+int
+add_map_rule(rule_map* map,
+             const life_rule* rule)
+{
+    for (size_t i = 0; i != map->rule_count; ++i)
+        if (map->rules[i].birth == rule->birth && map->rules[i].survive == rule->survive)
+            return i;
+
+    if (map->rule_count == RULE_MAP_SIZE)
+        return -1;
+
+    const size_t id = map->rule_count++;
+    map->rules[id] = (*rule);
+    map->kernels[id] = load_rule_kernel(rule, &map->libraries[id]);
+    if (map->kernels[id] == NULL)
+        map->kernels[id] = sub_update_rule;
+    return id;
+}
+
+// A map of the grid with every tile following the grid's rule.
+rule_map
+create_rule_map(const grid* g)
+{
+    rule_map map =
+    {
+        .tile_rows = (g->rows + RULE_TILE - 1) / RULE_TILE,
+        .tile_cols = g->row_words,
+        .rule_count = 0,
+    };
+    map.ids = calloc(map.tile_rows * map.tile_cols, sizeof(uint8_t));
+    add_map_rule(&map, &g->rule);
+    return map;
+}
+
+void
+destroy_rule_map(rule_map* map)
+{
+    for (size_t i = 0; i != map->rule_count; ++i)
+        if (map->libraries[i] != NULL)
+            dlclose(map->libraries[i]);
+
+    free(map->ids);
+    map->ids = NULL;
+    map->rule_count = 0;
+}
+
+// Sets the tiles [tile_row_begin, tile_row_end) x [tile_col_begin, tile_col_end).
+void
+fill_tile_rules(rule_map* map,
+                const size_t tile_row_begin,
+                const size_t tile_col_begin,
+                const size_t tile_row_end,
+                const size_t tile_col_end,
+                const uint8_t id)
+{
+    for (size_t i = tile_row_begin; i != tile_row_end; ++i)
+        for (size_t j = tile_col_begin; j != tile_col_end; ++j)
+            map->ids[i * map->tile_cols + j] = id;
+}
+
+///////////////////////////////////////////////////////////
+/// Space-time recursion
+///////////////////////////////////////////////////////////
+// Computes the trapezoid of generations [t0, t1), counted from the grid's
+// current generation. Generation t0 + k covers rows
+// [x0 + dx0 * k, x1 + dx1 * k), a slope of -1, 0 or 1 on each side.
+// The rows of generation t are read from plane (plane + t) % 2 and
+// written to the other one.
+void
+walk_trapezoid(const grid* g,
+               const int64_t t0,
+               const int64_t t1,
+               const int64_t x0,
+               const int64_t dx0,
+               const int64_t x1,
+               const int64_t dx1)
+{
+    const int64_t dt = t1 - t0;
+
+    if (dt == 1)
+    {
+        if (x1 > x0)
+            step_rows(g, (g->plane + t0) % 2, x0, x1);
+    }
+    else if (dt > 1)
+    {
+        if (2 * (x1 - x0) + (dx1 - dx0) * dt >= 4 * dt)
+        {
+            // Wide enough to cut in two along a slope of -1,
+            // the left part does not depend on the right one.
+            const int64_t xm = (2 * (x0 + x1) + (2 + dx0 + dx1) * dt) / 4;
+            walk_trapezoid(g, t0, t1, x0, dx0, xm, -1);
+            walk_trapezoid(g, t0, t1, xm, -1, x1, dx1);
+        }
+        else
+        {
+            const int64_t s = dt / 2;
+            walk_trapezoid(g, t0, t0 + s, x0, dx0, x1, dx1);
+            walk_trapezoid(g, t0 + s, t1, x0 + dx0 * s, dx0, x1 + dx1 * s, dx1);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////
+/// SDL
+///////////////////////////////////////////////////////////
+bool
+handle_events(grid* g,
+              bool* iterate,
+              size_t* generations,
+              bool* memoize,
+              bool* hybrid,
+              bool* edited)
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_QUIT ||
+            (event.type == SDL_KEYUP &&
+             event.key.keysym.sym == SDLK_ESCAPE))
+        {
+            return false;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_SPACE)
+        {
+            (*iterate) = !(*iterate);
+        }
+
+        // Many generations per update, through the space-time recursion
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_t)
+        {
+            (*generations) = ((*generations) == 1) ? TIME_BLOCK : 1;
+        }
+
+        // MEMO_GENERATIONS per update, through the tile table
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_m)
+        {
+            (*memoize) = !(*memoize);
+        }
+
+        // Engine picked by the hybrid driver
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_h)
+        {
+            (*hybrid) = !(*hybrid);
+        }
+
+        if (event.type == SDL_MOUSEBUTTONUP)
+        {
+            const int selected_col = event.button.x / CELL_WIDTH;
+            const int selected_row = event.button.y / CELL_HEIGHT;
+
+            if (selected_col >= 0 && selected_col < (int)g->cols &&
+                selected_row >= 0 && selected_row < (int)g->rows)
+            {
+                set_cell(g, selected_row, selected_col,
+                         !get_cell(g, selected_row, selected_col));
+                (*edited) = true;
+            }
+        }
+    }
+    return true;
+}
+
+void
+draw_grid(const grid* g,
+          SDL_Renderer* renderer)
+{
+    SDL_Color prev_color;
+    SDL_GetRenderDrawColor(renderer,
+                           &prev_color.r,
+                           &prev_color.g,
+                           &prev_color.b,
+                           &prev_color.a);
+
+    SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
+
+    for (size_t i = 0; i != g->rows; ++i)
+    {
+        for (size_t j = 0; j != g->cols; ++j)
+        {
+            if (get_cell(g, i, j))
+            {
+                SDL_Rect rect =
+                {
+                    .x = j * CELL_WIDTH + BORDER_WIDTH,
+                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
+                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
+                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
+                };
+
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer,
+                           prev_color.r,
+                           prev_color.g,
+                           prev_color.b,
+                           prev_color.a);
+}
+
+///////////////////////////////////////////////////////////
+/// Threads
+///////////////////////////////////////////////////////////
+// Contains all information needed by a single thread to run.
+typedef struct
+{
+    grid* g;
+    size_t row_begin;
+    size_t row_end;
+    size_t generations;
+    // Generations per trapezoid, small enough for the narrowest band
+    size_t block_height;
+
+    // Synchronization vars
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    pthread_barrier_t* barrier;
+} thread_params;
+
+void
+update_band(const thread_params* args)
+{
+    const grid* g = args->g;
+    step_rows(g, g->plane, args->row_begin, args->row_end);
+}
+
+// Every thread walks the same blocks of generations. Upright trapezoids
+// shrink inside each band, so bands can run them side by side, the
+// inverted ones then grow from each band boundary into the gap left.
+// A side on the grid border is vertical, rows outside are always dead.
+void
+update_trapezoids(const thread_params* args)
+{
+    const grid* g = args->g;
+    const int64_t row_begin = args->row_begin;
+    const int64_t row_end = args->row_end;
+    const int64_t left_slope = (args->row_begin == 0) ? 0 : 1;
+    const int64_t right_slope = (args->row_end == g->rows) ? 0 : -1;
+
+    for (size_t t = 0; t < args->generations; t += args->block_height)
+    {
+        const size_t remaining = args->generations - t;
+        const size_t height = (remaining < args->block_height) ? remaining : args->block_height;
+
+        walk_trapezoid(g, t, t + height, row_begin, left_slope, row_end, right_slope);
+        pthread_barrier_wait(args->barrier);
+
+        if (args->row_begin != 0)
+            walk_trapezoid(g, t, t + height, row_begin, -1, row_begin, 1);
+        pthread_barrier_wait(args->barrier);
+    }
+}
+
+void
+run_generations(const thread_params* args)
+{
+    if (args->generations == 1)
+        update_band(args);
+    else
+        update_trapezoids(args);
+}
+
+void*
+thread_execution(void* params)
+{
+    thread_params* args = (thread_params*)params;
+    size_t seen = 0;
+    while (true)
+    {
+        pthread_mutex_lock(args->cv_mtx);
+        while (atomic_load_explicit(args->running, memory_order_relaxed) &&
+               atomic_load_explicit(args->generation, memory_order_relaxed) == seen)
+        {
+            pthread_cond_wait(args->cv, args->cv_mtx);
+        }
+        pthread_mutex_unlock(args->cv_mtx);
+
+        if (!atomic_load_explicit(args->running, memory_order_relaxed))
+            break;
+
+        seen = atomic_load_explicit(args->generation, memory_order_acquire);
+        run_generations(args);
+
+        atomic_fetch_add_explicit(args->signal, 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Holds all variables that needs to be deallocated,
+// and that is used to communicate between threads.
+typedef struct
+{
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    pthread_barrier_t* barrier;
+    pthread_t* threads;
+    thread_params* params;
+} thread_info;
+
+thread_info
+create_threads(grid* g)
+{
+    thread_info info =
+    {
+        .running = malloc(sizeof(atomic_bool)),
+        .generation = malloc(sizeof(atomic_size_t)),
+        .signal = malloc(sizeof(atomic_int)),
+        .cv = malloc(sizeof(pthread_cond_t)),
+        .cv_mtx = malloc(sizeof(pthread_mutex_t)),
+        .barrier = malloc(sizeof(pthread_barrier_t)),
+        .threads = malloc((THREAD_COUNT - 1) * sizeof(pthread_t)),
+        .params = malloc((THREAD_COUNT) * sizeof(thread_params)),
+    };
+
+    atomic_init(info.running, true);
+    atomic_init(info.generation, 0);
+    atomic_init(info.signal, 0);
+    pthread_cond_init(info.cv, NULL);
+    pthread_mutex_init(info.cv_mtx, NULL);
+    pthread_barrier_init(info.barrier, NULL, THREAD_COUNT);
+
+    // An upright trapezoid loses a row on each side per generation
+    const size_t narrowest = g->rows / THREAD_COUNT;
+    const size_t block_height = (narrowest / 2 > 1) ? narrowest / 2 : 1;
+
+    // Initialize threads and start execution
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        info.params[i].g = g;
+        info.params[i].row_begin = (g->rows * i) / THREAD_COUNT;
+        info.params[i].row_end = (g->rows * (i + 1)) / THREAD_COUNT;
+        info.params[i].generations = 1;
+        info.params[i].block_height = block_height;
+        info.params[i].running = info.running;
+        info.params[i].generation = info.generation;
+        info.params[i].signal = info.signal;
+        info.params[i].cv = info.cv;
+        info.params[i].cv_mtx = info.cv_mtx;
+        info.params[i].barrier = info.barrier;
+    }
+
+    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
+        pthread_create(&info.threads[i], NULL, thread_execution, &info.params[i + 1]);
+
+    return info;
+}
+
+void
+destroy_threads(thread_info* info)
+{
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_store_explicit(info->running, false, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    for (size_t i = 0; i < THREAD_COUNT - 1; ++i)
+        pthread_join(info->threads[i], NULL);
+
+    pthread_cond_destroy(info->cv);
+    pthread_mutex_destroy(info->cv_mtx);
+    pthread_barrier_destroy(info->barrier);
+    free(info->running);
+    free(info->generation);
+    free(info->signal);
+    free(info->cv);
+    free(info->cv_mtx);
+    free(info->barrier);
+    free(info->threads);
+    free(info->params);
+}
+
+// Advances the grid the given number of generations.
+void
+update_grid(thread_info* info,
+            grid* g,
+            const size_t generations)
+{
+    // Awake all threads
+    pthread_mutex_lock(info->cv_mtx);
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        info->params[i].generations = generations;
+
+    atomic_fetch_add_explicit(info->generation, 1, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    run_generations(&info->params[0]);
+
+    int expected = THREAD_COUNT - 1;
+    while (!atomic_compare_exchange_weak_explicit(info->signal,
+                                                  &expected,
+                                                  0,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+    {
+        expected = THREAD_COUNT - 1;
+    }
+
+    // Nothing to copy, the plane of the last generation is the current one now
+    g->plane = (g->plane + generations) % 2;
+}
+
+///////////////////////////////////////////////////////////
+/// Tile memoization
+///////////////////////////////////////////////////////////
+// The grid is cut in tiles, and after MEMO_GENERATIONS the core of a
+// tile only depends on the window reaching that many cells around it.
+// Results are cached by window contents in a direct mapped table,
+// a colliding window simply replaces the older one, so the table stays
+// bounded. Windows crossing the grid border also carry which of their
+// rows and columns are inside, those outside stay dead every generation.
+//
+// A tile that keeps missing is chaotic and skips the table for a while,
+// the row of tiles holding it is stepped with the word kernel instead.
+// When most tiles are chaotic the whole grid is stepped, which does not
+// redo the overlap between rows of tiles.
+typedef struct
+{
+    uint32_t window[MEMO_WINDOW];
+    uint32_t row_mask;
+    uint32_t col_mask;
+    uint16_t core[MEMO_TILE];
+    bool used;
+} memo_entry;
+
+typedef struct
+{
+    memo_entry* table;
+    size_t tile_rows;
+    size_t tile_cols;
+    // Per tile: consecutive misses, and passes left without the table
+    uint8_t* misses;
+    uint8_t* chaotic;
+    // MEMO_WINDOW rows around a row of tiles, for the word kernel
+    uint64_t* band[2];
+
+    // Statistics
+    uint64_t hits;
+    uint64_t lookups;
+    uint64_t direct;
+} memo_state;
+
+memo_state
+create_memo(const grid* g)
+{
+    memo_state memo =
+    {
+        .table = calloc(MEMO_TABLE_SIZE, sizeof(memo_entry)),
+        .tile_rows = (g->rows + MEMO_TILE - 1) / MEMO_TILE,
+        .tile_cols = (g->cols + MEMO_TILE - 1) / MEMO_TILE,
+    };
+    memo.misses = calloc(memo.tile_rows * memo.tile_cols, sizeof(uint8_t));
+    memo.chaotic = calloc(memo.tile_rows * memo.tile_cols, sizeof(uint8_t));
+    memo.band[0] = calloc(MEMO_WINDOW * g->row_words, sizeof(uint64_t));
+    memo.band[1] = calloc(MEMO_WINDOW * g->row_words, sizeof(uint64_t));
+    return memo;
+}
+
+void
+destroy_memo(memo_state* memo)
+{
+    free(memo->table);
+    free(memo->misses);
+    free(memo->chaotic);
+    free(memo->band[0]);
+    free(memo->band[1]);
+    memo->table = NULL;
+    memo->band[0] = NULL;
+    memo->band[1] = NULL;
+    memo->misses = NULL;
+    memo->chaotic = NULL;
+}
+
+// Copies the MEMO_WINDOW rows around a row of tiles from the current
+// plane into the first band buffer, rows past the grid border read as dead.
+void
+load_tile_band(memo_state* memo,
+               const grid* g,
+               const size_t tile_row)
+{
+    const size_t row_words = g->row_words;
+    const int64_t row_begin = (int64_t)(tile_row * MEMO_TILE) - MEMO_GENERATIONS;
+
+    for (size_t i = 0; i != MEMO_WINDOW; ++i)
+    {
+        const int64_t row = row_begin + i;
+        for (size_t w = 0; w != row_words; ++w)
+        {
+            memo->band[0][i * row_words + w] = (row >= 0 && row < (int64_t)g->rows)
+                ? g->words[((size_t)(row + 1) * row_words + w) * 2 + g->plane]
+                : 0;
+        }
+    }
+}
+
+// 64 bits of a band row starting at physical bit `bit`,
+// anything outside the row reads as dead.
+uint64_t
+get_band_bits(const uint64_t* row,
+              const size_t row_words,
+              const int64_t bit)
+{
+    const int64_t word = (bit >= 0) ? bit / 64 : (bit - 63) / 64;
+    const int64_t offset = bit - word * 64;
+
+    const uint64_t low = (word >= 0 && word < (int64_t)row_words) ? row[word] : 0;
+    const uint64_t high = (word + 1 < (int64_t)row_words) ? row[word + 1] : 0;
+
+    if (offset == 0)
+        return low;
+    return (low >> offset) | (high << (64 - offset));
+}
+
+// Advances a window MEMO_GENERATIONS generations in place. Cells outside
+// the window are taken as dead, the error creeps in one cell per
+// generation, so only the rows it has not reached yet are stepped.
+void
+step_window(uint64_t rows[MEMO_WINDOW],
+            const uint32_t row_mask,
+            const uint32_t col_mask)
+{
+    uint64_t next[MEMO_WINDOW];
+
+    for (size_t gen = 0; gen != MEMO_GENERATIONS; ++gen)
+    {
+        for (size_t i = gen + 1; i + gen + 1 != MEMO_WINDOW; ++i)
+        {
+            const uint64_t above = rows[i - 1];
+            const uint64_t below = rows[i + 1];
+            const uint64_t neighbors[8] =
+            {
+                above << 1, above, above >> 1,
+                rows[i] << 1, rows[i] >> 1,
+                below << 1, below, below >> 1,
+            };
+
+            const uint64_t alive = ((row_mask >> i) & 1) ? col_mask : 0;
+            next[i] = life_rule_word(neighbors, rows[i]) & alive;
+        }
+        memcpy(&rows[gen + 1], &next[gen + 1], (MEMO_WINDOW - 2 * gen - 2) * sizeof(uint64_t));
+    }
+}
+
+uint64_t
+hash_window(const uint32_t window[MEMO_WINDOW],
+            const uint32_t row_mask,
+            const uint32_t col_mask)
+{
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (((uint64_t)row_mask << 32) | col_mask);
+    for (size_t i = 0; i != MEMO_WINDOW; i += 2)
+    {
+        hash ^= ((uint64_t)window[i + 1] << 32) | window[i];
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Core of a tile MEMO_GENERATIONS generations ahead, from the table
+// when it can, otherwise by stepping its window.
+// The band around its row of tiles must be loaded.
+void
+memo_tile(memo_state* memo,
+          const grid* g,
+          const size_t tile_row,
+          const size_t tile_col,
+          const uint32_t row_mask,
+          uint16_t core[MEMO_TILE])
+{
+    const int64_t col_begin = (int64_t)(tile_col * MEMO_TILE) - MEMO_GENERATIONS;
+
+    uint32_t window[MEMO_WINDOW];
+    uint32_t col_mask = 0;
+    uint32_t any = 0;
+
+    for (size_t j = 0; j != MEMO_WINDOW; ++j)
+    {
+        const int64_t col = col_begin + j;
+        if (col >= 0 && col < (int64_t)g->cols)
+            col_mask |= 1U << j;
+    }
+
+    for (size_t i = 0; i != MEMO_WINDOW; ++i)
+    {
+        window[i] = (uint32_t)get_band_bits(&memo->band[0][i * g->row_words],
+                                            g->row_words,
+                                            col_begin + 1);
+        any |= window[i];
+    }
+
+    // Nothing alive within reach, nothing alive in the core
+    if (any == 0)
+    {
+        memset(core, 0, MEMO_TILE * sizeof(uint16_t));
+        return;
+    }
+
+    const size_t tile = tile_row * memo->tile_cols + tile_col;
+    memo_entry* entry = &memo->table[hash_window(window, row_mask, col_mask) % MEMO_TABLE_SIZE];
+    ++memo->lookups;
+
+    if (entry->used &&
+        entry->row_mask == row_mask &&
+        entry->col_mask == col_mask &&
+        memcmp(entry->window, window, sizeof(window)) == 0)
+    {
+        memcpy(core, entry->core, MEMO_TILE * sizeof(uint16_t));
+        memo->misses[tile] = 0;
+        ++memo->hits;
+        return;
+    }
+
+    if (++memo->misses[tile] == MEMO_MISS_LIMIT)
+    {
+        memo->misses[tile] = 0;
+        memo->chaotic[tile] = MEMO_RETRY;
+    }
+
+    uint64_t rows[MEMO_WINDOW];
+    for (size_t i = 0; i != MEMO_WINDOW; ++i)
+        rows[i] = window[i];
+
+    step_window(rows, row_mask, col_mask);
+
+    for (size_t i = 0; i != MEMO_TILE; ++i)
+        core[i] = (uint16_t)(rows[i + MEMO_GENERATIONS] >> MEMO_GENERATIONS);
+
+    memcpy(entry->window, window, sizeof(window));
+    memcpy(entry->core, core, MEMO_TILE * sizeof(uint16_t));
+    entry->row_mask = row_mask;
+    entry->col_mask = col_mask;
+    entry->used = true;
+}
+
+// Steps the loaded band MEMO_GENERATIONS generations with the word
+// kernel, over the full width. The band shrinks by a row on each side
+// every generation, its core rows end up in the first band buffer.
+void
+step_tile_band(memo_state* memo,
+               const grid* g,
+               const size_t tile_row)
+{
+    const size_t row_words = g->row_words;
+    const int64_t row_begin = (int64_t)(tile_row * MEMO_TILE) - MEMO_GENERATIONS;
+    uint64_t* src = memo->band[0];
+    uint64_t* dst = memo->band[1];
+
+    for (size_t gen = 0; gen != MEMO_GENERATIONS; ++gen)
+    {
+        sub_update(dst, src, 1, gen, MEMO_WINDOW - gen - 2, row_words, g->cols);
+
+        // Rows past the grid border stay dead
+        for (size_t i = gen + 1; i + gen + 1 != MEMO_WINDOW; ++i)
+        {
+            const int64_t row = row_begin + i;
+            if (row < 0 || row >= (int64_t)g->rows)
+                memset(&dst[i * row_words], 0, row_words * sizeof(uint64_t));
+        }
+
+        uint64_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+}
+
+// Advances the grid MEMO_GENERATIONS generations, tile by tile
+// into the other plane. The table is not shared, so this runs on
+// the calling thread, only the whole grid fallback uses the workers.
+void
+update_grid_memo(thread_info* info,
+                 memo_state* memo,
+                 grid* g)
+{
+    // Tiles are stepped under Life, other rules go through their kernel
+    if (g->kernel != NULL || g->rule_map != NULL)
+    {
+        update_grid(info, g, MEMO_GENERATIONS);
+        return;
+    }
+
+    const size_t tile_count = memo->tile_rows * memo->tile_cols;
+    size_t chaotic_count = 0;
+    for (size_t t = 0; t != tile_count; ++t)
+        chaotic_count += memo->chaotic[t] != 0;
+
+    if (chaotic_count * 2 > tile_count)
+    {
+        for (size_t t = 0; t != tile_count; ++t)
+            memo->chaotic[t] -= memo->chaotic[t] != 0;
+
+        memo->direct += tile_count;
+        update_grid(info, g, MEMO_GENERATIONS);
+        return;
+    }
+
+    const size_t row_words = g->row_words;
+    const size_t next_plane = 1 - g->plane;
+    for (size_t tile_row = 0; tile_row != memo->tile_rows; ++tile_row)
+    {
+        uint8_t* chaotic = &memo->chaotic[tile_row * memo->tile_cols];
+        bool any_chaotic = false;
+        for (size_t tile_col = 0; tile_col != memo->tile_cols; ++tile_col)
+            any_chaotic |= chaotic[tile_col] != 0;
+
+        load_tile_band(memo, g, tile_row);
+
+        // Core rows of the band, in the first band buffer
+        uint64_t* core_rows = &memo->band[0][MEMO_GENERATIONS * row_words];
+
+        if (any_chaotic)
+        {
+            for (size_t tile_col = 0; tile_col != memo->tile_cols; ++tile_col)
+                chaotic[tile_col] -= chaotic[tile_col] != 0;
+
+            memo->direct += memo->tile_cols;
+            step_tile_band(memo, g, tile_row);
+        }
+        else
+        {
+            uint32_t row_mask = 0;
+            for (size_t i = 0; i != MEMO_WINDOW; ++i)
+            {
+                const int64_t row = (int64_t)(tile_row * MEMO_TILE) - MEMO_GENERATIONS + i;
+                if (row >= 0 && row < (int64_t)g->rows)
+                    row_mask |= 1U << i;
+            }
+
+            // The windows are all read, the core rows can be assembled
+            // in the second band buffer
+            uint64_t* out = memo->band[1];
+            memset(out, 0, MEMO_TILE * row_words * sizeof(uint64_t));
+
+            for (size_t tile_col = 0; tile_col != memo->tile_cols; ++tile_col)
+            {
+                uint16_t core[MEMO_TILE];
+                memo_tile(memo, g, tile_row, tile_col, row_mask, core);
+
+                const size_t bit = tile_col * MEMO_TILE + 1;
+                const size_t word = bit / 64;
+                const size_t offset = bit % 64;
+                for (size_t i = 0; i != MEMO_TILE; ++i)
+                {
+                    out[i * row_words + word] |= (uint64_t)core[i] << offset;
+                    if (offset > 64 - MEMO_TILE && word + 1 != row_words)
+                        out[i * row_words + word + 1] |= (uint64_t)core[i] >> (64 - offset);
+                }
+            }
+            core_rows = out;
+        }
+
+        for (size_t i = 0; i != MEMO_TILE; ++i)
+        {
+            const size_t row = tile_row * MEMO_TILE + i;
+            if (row >= g->rows)
+                break;
+
+            for (size_t w = 0; w != row_words; ++w)
+                g->words[((row + 1) * row_words + w) * 2 + next_plane] = core_rows[i * row_words + w];
+        }
+    }
+
+    g->plane = next_plane;
+}
+
+///////////////////////////////////////////////////////////
+/// Clock
+///////////////////////////////////////////////////////////
+double
+get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+///////////////////////////////////////////////////////////
+/// Hybrid
+///////////////////////////////////////////////////////////
+typedef enum
+{
+    ENGINE_DENSE,
+    ENGINE_SPARSE,
+    ENGINE_MEMO,
+    ENGINE_PERIODIC,
+} engine_kind;
+
+const char* engine_names[4] = { "dense", "sparse", "tile memo", "periodic" };
+
+// Picks the engine for the next HYBRID_SAMPLE updates from what the
+// last sample saw. All engines step the same planes, so switching
+// only means starting or dropping the bookkeeping of an engine.
+typedef struct
+{
+    engine_kind engine;
+    size_t updates;
+
+    // changed[0][(i + 1) * row_words + w] if word w of row i changed in
+    // the last generation, the sparse engine steps only words next to a
+    // changed word. Like the grid, there is a row of border above and below.
+    uint8_t* changed[2];
+    // Old words of the row being sampled
+    uint64_t* row_buffer;
+
+    // Seconds per generation, averaged over the intervals each engine
+    // ran, the sparse cost is per generation and fraction of words changing
+    double cost[4];
+    double interval_seconds;
+    size_t interval_generations;
+    double interval_activity;
+    size_t probe;
+
+    // Last sample
+    double density;
+    double activity;
+    size_t period;
+
+    size_t generations[4];
+    memo_state* memo;
+} hybrid_state;
+
+hybrid_state
+create_hybrid(const grid* g,
+              memo_state* memo)
+{
+    hybrid_state hybrid =
+    {
+        .engine = ENGINE_DENSE,
+        .updates = 0,
+        .changed =
+        {
+            calloc((g->rows + 2) * g->row_words, 1),
+            calloc((g->rows + 2) * g->row_words, 1),
+        },
+        .row_buffer = malloc(g->row_words * sizeof(uint64_t)),
+        .cost = { 0.0, 0.0, 0.0, 0.0 },
+        .interval_seconds = 0.0,
+        .interval_generations = 0,
+        .interval_activity = 1.0,
+        .probe = 0,
+        .density = 0.0,
+        .activity = 1.0,
+        .period = 0,
+        .generations = { 0, 0, 0, 0 },
+        .memo = memo,
+    };
+    memset(hybrid.changed[0] + g->row_words, 1, g->rows * g->row_words);
+    return hybrid;
+}
+
+void
+destroy_hybrid(hybrid_state* hybrid)
+{
+    free(hybrid->changed[0]);
+    free(hybrid->changed[1]);
+    free(hybrid->row_buffer);
+    hybrid->changed[0] = hybrid->changed[1] = NULL;
+    hybrid->row_buffer = NULL;
+}
+
+// Cells were edited, or stepped by another engine, nothing learned
+// about the old state holds.
+void
+reset_hybrid(hybrid_state* hybrid,
+             const grid* g)
+{
+    hybrid->engine = ENGINE_DENSE;
+    hybrid->updates = 0;
+    hybrid->interval_seconds = 0.0;
+    hybrid->interval_generations = 0;
+    hybrid->period = 0;
+    memset(hybrid->changed[0] + g->row_words, 1, g->rows * g->row_words);
+}
+
+// Next state of word w of a row, the kernel of the sparse engine.
+uint64_t
+step_word(const grid* g,
+          const size_t plane,
+          const size_t row,
+          const size_t w)
+{
+    const size_t row_words = g->row_words;
+    const uint64_t* above = &g->words[(row + 0) * row_words * 2 + plane];
+    const uint64_t* curr = &g->words[(row + 1) * row_words * 2 + plane];
+    const uint64_t* below = &g->words[(row + 2) * row_words * 2 + plane];
+
+    const size_t idx = w * 2;
+    const size_t prev_idx = (w != 0) ? idx - 2 : idx;
+    const size_t next_idx = (w + 1 != row_words) ? idx + 2 : idx;
+    const uint64_t first = (w != 0);
+    const uint64_t last = (w + 1 != row_words);
+
+    const uint64_t neighbors[8] =
+    {
+        (above[idx] << 1) | ((above[prev_idx] >> 63) & first),
+        above[idx],
+        (above[idx] >> 1) | ((above[next_idx] << 63) & (last << 63)),
+        (curr[idx] << 1) | ((curr[prev_idx] >> 63) & first),
+        (curr[idx] >> 1) | ((curr[next_idx] << 63) & (last << 63)),
+        (below[idx] << 1) | ((below[prev_idx] >> 63) & first),
+        below[idx],
+        (below[idx] >> 1) | ((below[next_idx] << 63) & (last << 63)),
+    };
+
+    const life_rule* rule = &g->rule;
+    if (g->rule_map != NULL)
+    {
+        const rule_map* map = g->rule_map;
+        rule = &map->rules[map->ids[((g->map_row + row) / RULE_TILE) * map->tile_cols + g->map_word + w]];
+    }
+
+    const uint64_t next = is_life_rule(rule) ? life_rule_word(neighbors, curr[idx])
+                                             : rule_word(neighbors, curr[idx], rule);
+    return next & get_word_mask(g->cols, w);
+}
+
+// One generation, stepping only the words a changed word is next to.
+// A word whose neighbourhood did not change in the last generation
+// keeps its state, and the plane written to already holds it.
+void
+step_sparse(hybrid_state* hybrid,
+            grid* g)
+{
+    const size_t row_words = g->row_words;
+    const uint8_t* changed = hybrid->changed[0];
+    uint8_t* next_changed = hybrid->changed[1];
+    const size_t plane = g->plane;
+
+    for (size_t row = 0; row != g->rows; ++row)
+    {
+        const uint8_t* above = &changed[(row + 0) * row_words];
+        const uint8_t* curr = &changed[(row + 1) * row_words];
+        const uint8_t* below = &changed[(row + 2) * row_words];
+        uint8_t* out = &next_changed[(row + 1) * row_words];
+        uint64_t* words = &g->words[(row + 1) * row_words * 2];
+
+        for (size_t w = 0; w != row_words; ++w)
+        {
+            uint8_t near = above[w] | curr[w] | below[w];
+            if (w != 0)
+                near |= above[w - 1] | curr[w - 1] | below[w - 1];
+            if (w + 1 != row_words)
+                near |= above[w + 1] | curr[w + 1] | below[w + 1];
+
+            if (near == 0)
+            {
+                out[w] = 0;
+                continue;
+            }
+
+            const uint64_t next = step_word(g, plane, row, w);
+            out[w] = next != words[w * 2 + plane];
+            words[w * 2 + 1 - plane] = next;
+        }
+    }
+
+    hybrid->changed[1] = hybrid->changed[0];
+    hybrid->changed[0] = next_changed;
+    g->plane = 1 - plane;
+}
+
+// Two generations row by row, keeping what each row held two
+// generations ago to compare with. Measures the density, the words
+// that changed, and whether the whole grid has period 1 or 2,
+// in which case the two planes hold all of its future.
+// The other plane is only known to hold the generation before after
+// the first of the two, the tile memo leaves an older one there.
+void
+sample_hybrid(hybrid_state* hybrid,
+              grid* g)
+{
+    size_t population = 0;
+    size_t active = 0;
+    bool same_as_last = true;
+    bool same_as_before_last = true;
+
+    for (size_t gen = 0; gen != HYBRID_SAMPLE_GENERATIONS; ++gen)
+    {
+        const size_t plane = g->plane;
+        population = 0;
+        active = 0;
+        same_as_last = true;
+        same_as_before_last = true;
+
+        for (size_t row = 0; row != g->rows; ++row)
+        {
+            uint64_t* words = &g->words[(row + 1) * g->row_words * 2];
+            for (size_t w = 0; w != g->row_words; ++w)
+            {
+                hybrid->row_buffer[w] = words[w * 2 + 1 - plane];
+                population += __builtin_popcountll(words[w * 2 + plane]);
+            }
+
+            step_rows(g, plane, row, row + 1);
+
+            uint8_t* changed = &hybrid->changed[0][(row + 1) * g->row_words];
+            for (size_t w = 0; w != g->row_words; ++w)
+            {
+                const uint64_t next = words[w * 2 + 1 - plane];
+                changed[w] = next != words[w * 2 + plane];
+                active += changed[w];
+                same_as_last &= !changed[w];
+                same_as_before_last &= next == hybrid->row_buffer[w];
+            }
+        }
+        g->plane = 1 - plane;
+    }
+
+    hybrid->density = (double)population / ((double)g->rows * g->cols);
+    hybrid->activity = (double)active / ((double)g->rows * g->row_words);
+    hybrid->period = same_as_last ? 1 : same_as_before_last ? 2 : 0;
+}
+
+// Folds the time the engine took since the last sample into its cost.
+void
+record_engine_cost(hybrid_state* hybrid)
+{
+    if (hybrid->interval_generations == 0)
+        return;
+
+    double cost = hybrid->interval_seconds / hybrid->interval_generations;
+    if (hybrid->engine == ENGINE_SPARSE)
+        cost /= (hybrid->interval_activity > 0.01) ? hybrid->interval_activity : 0.01;
+
+    double* average = &hybrid->cost[hybrid->engine];
+    (*average) = ((*average) == 0.0) ? cost : ((*average) + cost) / 2;
+    hybrid->interval_seconds = 0.0;
+    hybrid->interval_generations = 0;
+}
+
+// The cost model: a periodic grid costs nothing, the sparse engine
+// costs its measured cost scaled by the words changing, the dense
+// engine and the tile memo cost what they were measured to.
+// An engine not measured yet is tried, and every HYBRID_PROBE samples
+// the runner up is, so its cost follows the grid. Leaving the dense
+// engine takes a clear win, the measurements are noisy.
+engine_kind
+choose_engine(hybrid_state* hybrid)
+{
+    if (hybrid->period != 0)
+        return ENGINE_PERIODIC;
+
+    const bool candidates[3] =
+    {
+        true,
+        hybrid->activity < HYBRID_SPARSE_ACTIVITY,
+        hybrid->density < HYBRID_MEMO_DENSITY,
+    };
+
+    double predicted[3];
+    for (size_t e = 0; e != 3; ++e)
+    {
+        if (!candidates[e])
+            continue;
+        if (hybrid->cost[e] == 0.0)
+            return (engine_kind)e;
+
+        predicted[e] = hybrid->cost[e] * ((e == ENGINE_SPARSE) ? hybrid->activity : 1.0);
+        if (e != ENGINE_DENSE)
+            predicted[e] /= HYBRID_MARGIN;
+    }
+
+    size_t best = ENGINE_DENSE;
+    size_t runner_up = ENGINE_DENSE;
+    for (size_t e = 1; e != 3; ++e)
+    {
+        if (!candidates[e])
+            continue;
+        if (predicted[e] < predicted[best])
+        {
+            runner_up = best;
+            best = e;
+        }
+        else if (runner_up == best || predicted[e] < predicted[runner_up])
+        {
+            runner_up = e;
+        }
+    }
+
+    if (++hybrid->probe % HYBRID_PROBE == 0)
+        return (engine_kind)runner_up;
+    return (engine_kind)best;
+}
+
+// Advances the grid MEMO_GENERATIONS generations with whichever
+// engine the last sample chose, sampling every HYBRID_SAMPLE updates.
+// A periodic grid is sampled as well, it costs little next to
+// trusting a period that no longer holds.
+void
+update_grid_hybrid(thread_info* info,
+                   hybrid_state* hybrid,
+                   grid* g)
+{
+    size_t generations = MEMO_GENERATIONS;
+    if (hybrid->updates++ % HYBRID_SAMPLE == 0)
+    {
+        record_engine_cost(hybrid);
+        sample_hybrid(hybrid, g);
+        hybrid->engine = choose_engine(hybrid);
+        hybrid->interval_activity = hybrid->activity;
+        hybrid->generations[ENGINE_DENSE] += HYBRID_SAMPLE_GENERATIONS;
+        generations -= HYBRID_SAMPLE_GENERATIONS;
+
+        // The tile memo steps MEMO_GENERATIONS at once,
+        // the rest of this update runs dense
+        if (hybrid->engine == ENGINE_MEMO)
+        {
+            update_grid(info, g, generations);
+            hybrid->generations[ENGINE_DENSE] += generations;
+            return;
+        }
+    }
+
+    const double start = get_seconds();
+    switch (hybrid->engine)
+    {
+    case ENGINE_DENSE:
+        update_grid(info, g, generations);
+        break;
+    case ENGINE_SPARSE:
+        for (size_t gen = 0; gen != generations; ++gen)
+            step_sparse(hybrid, g);
+        break;
+    case ENGINE_MEMO:
+        update_grid_memo(info, hybrid->memo, g);
+        break;
+    case ENGINE_PERIODIC:
+        g->plane = (g->plane + generations) % 2;
+        break;
+    }
+    hybrid->interval_seconds += get_seconds() - start;
+    hybrid->interval_generations += generations;
+    hybrid->generations[hybrid->engine] += generations;
+}
+
+///////////////////////////////////////////////////////////
+/// Light cone
+///////////////////////////////////////////////////////////
+// Copies dst->rows x dst->cols cells of src, from (src_row, src_col) on,
+// into the current plane of dst. Cells past the end of src are dead.
+void
+copy_region(grid* dst,
+            const grid* src,
+            const size_t src_row,
+            const size_t src_col)
+{
+    for (size_t i = 0; i != dst->rows; ++i)
+    {
+        uint64_t* out = &dst->words[(i + 1) * dst->row_words * 2 + dst->plane];
+        if (src_row + i >= src->rows)
+        {
+            for (size_t w = 0; w != dst->row_words; ++w)
+                out[w * 2] = 0;
+            continue;
+        }
+
+        // Bit p of a dst row is bit p + src_col of the src row
+        const uint64_t* in = &src->words[(src_row + i + 1) * src->row_words * 2 + src->plane];
+        for (size_t w = 0; w != dst->row_words; ++w)
+        {
+            const size_t bit = w * 64 + src_col;
+            const size_t word = bit / 64;
+            const size_t shift = bit % 64;
+
+            uint64_t value = 0;
+            if (word < src->row_words)
+                value = in[word * 2] >> shift;
+            if (shift != 0 && word + 1 < src->row_words)
+                value |= in[(word + 1) * 2] << (64 - shift);
+
+            out[w * 2] = value & get_word_mask(dst->cols, w);
+        }
+    }
+}
+
+// A grid of dead cells, stepped under the same rule as g. A generated
+// kernel stays owned by g, which has to outlive the result.
+// The rule map of g is not followed, its tiles need not line up.
+grid
+create_grid_like(const grid* g,
+                 const size_t rows,
+                 const size_t cols)
+{
+    grid result =
+    {
+        .rows = rows,
+        .cols = cols,
+        .row_words = (cols + 2 + 63) / 64,
+        .plane = 0,
+        .rule = g->rule,
+        .kernel = g->kernel,
+        .kernel_library = NULL,
+        .rule_map = NULL,
+        .map_row = 0,
+        .map_word = 0,
+    };
+    result.words = calloc((rows + 2) * result.row_words * 2, sizeof(uint64_t));
+    return result;
+}
+
+// Cells [row, row + height) x [col, col + width) as they will be
+// generations from now, leaving the grid as it is. Only the light cone
+// of the region matters: the region grown by one cell per generation
+// on each side, cut to the grid, where cells stay dead. Each generation
+// the rows still inside the cone are stepped, a side cut by the window
+// loses a row per generation, a side on the grid border does not.
+// Columns are stepped in whole words, the stale ones at the window's
+// sides stay outside the region the same way. With a rule map the window
+// starts on a word of the grid, so its words are tiles of the map.
+grid
+future_region(const grid* g,
+              const size_t row,
+              const size_t col,
+              const size_t height,
+              const size_t width,
+              const size_t generations)
+{
+    const size_t window_row = (row > generations) ? row - generations : 0;
+    const size_t cone_col = (col > generations) ? col - generations : 0;
+    const size_t window_col = (g->rule_map != NULL) ? cone_col / 64 * 64 : cone_col;
+    const size_t row_end = (row + height + generations < g->rows) ? row + height + generations : g->rows;
+    const size_t col_end = (col + width + generations < g->cols) ? col + width + generations : g->cols;
+    const bool top_cut = window_row != 0;
+    const bool bottom_cut = row_end != g->rows;
+
+    grid window = create_grid_like(g, row_end - window_row, col_end - window_col);
+    window.rule_map = g->rule_map;
+    window.map_row = g->map_row + window_row;
+    window.map_word = g->map_word + window_col / 64;
+    copy_region(&window, g, window_row, window_col);
+
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        const size_t begin = top_cut ? gen + 1 : 0;
+        const size_t end = bottom_cut ? window.rows - gen - 1 : window.rows;
+        if (begin < end)
+            step_rows(&window, window.plane, begin, end);
+        window.plane = 1 - window.plane;
+    }
+
+    grid region = create_grid_like(g, height, width);
+    copy_region(&region, &window, row - window_row, col - window_col);
+    destroy_grid(&window);
+    return region;
+}
+
+///////////////////////////////////////////////////////////
+/// Benchmark
+///////////////////////////////////////////////////////////
+int
+run_benchmark(int argc,
+              char** argv)
+{
+    const size_t rows = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1024;
+    const size_t cols = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1024;
+    const size_t generations = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1000;
+    // The initial stripes are repetitive, a random soup is not
+    const bool soup = (argc <= 5) || strcmp(argv[5], "stripes") != 0;
+
+    grid g = create_grid(rows, cols);
+    srand(1);
+    for (size_t i = 0; soup && i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&g, i, j, rand() % 3 == 0);
+
+    // Separate grids hold the same cells, one plane each
+    const size_t word_count = (rows + 2) * g.row_words;
+    uint64_t* separate[2] =
+    {
+        calloc(word_count, sizeof(uint64_t)),
+        calloc(word_count, sizeof(uint64_t)),
+    };
+    uint64_t* copied[2] =
+    {
+        calloc(word_count, sizeof(uint64_t)),
+        calloc(word_count, sizeof(uint64_t)),
+    };
+    for (size_t i = 0; i != word_count; ++i)
+        separate[0][i] = copied[0][i] = g.words[i * 2];
+
+    grid walked = create_grid(rows, cols);
+    memcpy(walked.words, g.words, word_count * 2 * sizeof(uint64_t));
+    grid memoized = create_grid(rows, cols);
+    memcpy(memoized.words, g.words, word_count * 2 * sizeof(uint64_t));
+    grid fixed = create_grid(rows, cols);
+    memcpy(fixed.words, g.words, word_count * 2 * sizeof(uint64_t));
+
+    double start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        sub_update(g.words + (1 - g.plane), g.words + g.plane, 2,
+                   0, rows, g.row_words, cols);
+        g.plane = 1 - g.plane;
+    }
+    const double interleaved_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        sub_update(separate[1], separate[0], 1, 0, rows, g.row_words, cols);
+        uint64_t* tmp = separate[0];
+        separate[0] = separate[1];
+        separate[1] = tmp;
+    }
+    const double swapped_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        sub_update(copied[1], copied[0], 1, 0, rows, g.row_words, cols);
+        memcpy(copied[0], copied[1], word_count * sizeof(uint64_t));
+    }
+    const double copied_time = get_seconds() - start;
+
+    // Falls back to sub_update for widths without a specialization
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&fixed, fixed.plane, 0, rows);
+        fixed.plane = 1 - fixed.plane;
+    }
+    const double fixed_time = get_seconds() - start;
+
+    start = get_seconds();
+    walk_trapezoid(&walked, 0, generations, 0, 0, rows, 0);
+    walked.plane = (walked.plane + generations) % 2;
+    const double walked_time = get_seconds() - start;
+
+    // Falls back to the thread pool on chaotic grids
+    thread_info threads = create_threads(&memoized);
+    memo_state memo = create_memo(&memoized);
+    start = get_seconds();
+    for (size_t gen = 0; gen + MEMO_GENERATIONS <= generations; gen += MEMO_GENERATIONS)
+        update_grid_memo(&threads, &memo, &memoized);
+    if (generations % MEMO_GENERATIONS != 0)
+        update_grid(&threads, &memoized, generations % MEMO_GENERATIONS);
+    const double memo_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    bool same = true;
+    for (size_t i = 0; i != word_count; ++i)
+    {
+        same &= g.words[i * 2 + g.plane] == separate[0][i];
+        same &= g.words[i * 2 + g.plane] == copied[0][i];
+        same &= g.words[i * 2 + g.plane] == fixed.words[i * 2 + fixed.plane];
+        same &= g.words[i * 2 + g.plane] == walked.words[i * 2 + walked.plane];
+        same &= g.words[i * 2 + g.plane] == memoized.words[i * 2 + memoized.plane];
+    }
+
+    const double cells = (double)rows * cols * generations;
+    printf("%zu x %zu, %s, %zu generations, single thread\n",
+           rows, cols, soup ? "soup" : "stripes", generations);
+    printf("interleaved planes: %.3f s, %.3f ns/cell\n",
+           interleaved_time, interleaved_time * 1e9 / cells);
+    printf("separate, swapped:  %.3f s, %.3f ns/cell\n",
+           swapped_time, swapped_time * 1e9 / cells);
+    printf("separate, copied:   %.3f s, %.3f ns/cell\n",
+           copied_time, copied_time * 1e9 / cells);
+    printf("fixed width:        %.3f s, %.3f ns/cell, %zu bit rows%s\n",
+           fixed_time, fixed_time * 1e9 / cells, g.row_words * 64,
+           (g.row_words & (g.row_words - 1)) == 0 && g.row_words <= 16 ? "" : ", not specialized");
+    printf("space-time walk:    %.3f s, %.3f ns/cell\n",
+           walked_time, walked_time * 1e9 / cells);
+    printf("tile memo:          %.3f s, %.3f ns/cell, %.1f%% hits, %lu tiles stepped directly\n",
+           memo_time, memo_time * 1e9 / cells,
+           (memo.lookups != 0) ? memo.hits * 100.0 / memo.lookups : 0.0,
+           (unsigned long)memo.direct);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    free(separate[0]);
+    free(separate[1]);
+    free(copied[0]);
+    free(copied[1]);
+    destroy_memo(&memo);
+    destroy_grid(&fixed);
+    destroy_grid(&memoized);
+    destroy_grid(&walked);
+    destroy_grid(&g);
+    return same ? 0 : 1;
+}
+
+// Generic against generated kernel for one rule, on a random soup.
+int
+run_rule_benchmark(int argc,
+                   char** argv)
+{
+    life_rule rule;
+    if (argc < 3 || !parse_rule(argv[2], &rule))
+    {
+        fprintf(stderr, "usage: %s bench_rule <rule> [rows] [cols] [generations]\n", argv[0]);
+        return 1;
+    }
+
+    const size_t rows = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1024;
+    const size_t cols = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1024;
+    const size_t generations = (argc > 5) ? strtoul(argv[5], NULL, 10) : 1000;
+
+    grid generic = create_grid(rows, cols);
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&generic, i, j, rand() % 3 == 0);
+
+    grid generated = create_grid(rows, cols);
+    memcpy(generated.words, generic.words, (rows + 2) * generic.row_words * 2 * sizeof(uint64_t));
+
+    double start = get_seconds();
+    set_grid_rule(&generated, &rule);
+    const double load_time = get_seconds() - start;
+
+    generic.rule = rule;
+    generic.kernel = sub_update_rule;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&generic, generic.plane, 0, rows);
+        generic.plane = 1 - generic.plane;
+    }
+    const double generic_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&generated, generated.plane, 0, rows);
+        generated.plane = 1 - generated.plane;
+    }
+    const double generated_time = get_seconds() - start;
+
+    bool same = true;
+    for (size_t i = 0; i != (rows + 2) * generic.row_words; ++i)
+        same &= generic.words[i * 2 + generic.plane] == generated.words[i * 2 + generated.plane];
+
+    const char* kind = (generated.kernel == NULL) ? "hand-written Life kernel"
+                       : (generated.kernel == sub_update_rule) ? "generic kernel, no compiler"
+                       : "generated kernel";
+
+    const double cells = (double)rows * cols * generations;
+    printf("%s, %zu x %zu, %zu generations, single thread\n",
+           argv[2], rows, cols, generations);
+    printf("rule: ");
+    write_rule_expression(stdout, &rule);
+    printf("\n");
+    printf("generic kernel:     %.3f s, %.3f ns/cell\n",
+           generic_time, generic_time * 1e9 / cells);
+    printf("%-19s %.3f s, %.3f ns/cell, %.3f s to build or load\n",
+           kind, generated_time, generated_time * 1e9 / cells, load_time);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    destroy_grid(&generated);
+    destroy_grid(&generic);
+    return same ? 0 : 1;
+}
+
+// Steps 'dense' with the dense engine, and 'mixed', holding the same
+// cells, with the hybrid driver. With force_memo the driver starts on
+// the tile memo, so its first sample follows a memo interval, which
+// leaves an older generation in the other plane. With interleave,
+// every interleave-th update runs without the driver, through the
+// dense engine and the tile memo in turns, as switching it off in the
+// window does, and the driver is reset when it resumes.
+bool
+compare_hybrid(grid* dense,
+               grid* mixed,
+               const char* name,
+               const size_t updates,
+               const bool force_memo,
+               const size_t interleave)
+{
+    const size_t rows = dense->rows;
+    const size_t cols = dense->cols;
+    const size_t generations = updates * MEMO_GENERATIONS;
+
+    thread_info threads = create_threads(dense);
+    double start = get_seconds();
+    for (size_t update = 0; update != updates; ++update)
+        update_grid(&threads, dense, MEMO_GENERATIONS);
+    const double dense_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    threads = create_threads(mixed);
+    memo_state memo = create_memo(mixed);
+    hybrid_state hybrid = create_hybrid(mixed, &memo);
+    if (force_memo)
+    {
+        hybrid.engine = ENGINE_MEMO;
+        hybrid.updates = 1;
+    }
+    start = get_seconds();
+    for (size_t update = 0; update != updates; ++update)
+    {
+        if (interleave == 0 || (update + 1) % interleave != 0)
+        {
+            update_grid_hybrid(&threads, &hybrid, mixed);
+            continue;
+        }
+
+        if ((update / interleave) % 2 == 0)
+            update_grid(&threads, mixed, MEMO_GENERATIONS);
+        else
+            update_grid_memo(&threads, &memo, mixed);
+        reset_hybrid(&hybrid, mixed);
+    }
+    const double hybrid_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    bool same = true;
+    for (size_t i = 0; i != (rows + 2) * dense->row_words; ++i)
+        same &= dense->words[i * 2 + dense->plane] == mixed->words[i * 2 + mixed->plane];
+
+    const double cells = (double)rows * cols * generations;
+    printf("%zu x %zu, %s, %zu generations\n", rows, cols, name, generations);
+    printf("dense:  %.3f s, %.3f ns/cell\n", dense_time, dense_time * 1e9 / cells);
+    printf("hybrid: %.3f s, %.3f ns/cell\n", hybrid_time, hybrid_time * 1e9 / cells);
+    for (size_t e = 0; e != 4; ++e)
+        printf("    %-10s %lu generations\n", engine_names[e], (unsigned long)hybrid.generations[e]);
+    printf("last sample: density %.3f, %.1f%% words changing, period %zu\n",
+           hybrid.density, hybrid.activity * 100.0, hybrid.period);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    destroy_hybrid(&hybrid);
+    destroy_memo(&memo);
+    return same;
+}
+
+// Hybrid against dense engine, on a soup settling into ash, then on
+// pulsars (period 3) and a block, periodic but not with period 1 or 2,
+// then on the soup with updates outside the driver in between.
+int
+run_hybrid_benchmark(int argc,
+                     char** argv)
+{
+    const size_t rows = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1024;
+    const size_t cols = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1024;
+    const size_t updates = ((argc > 4) ? strtoul(argv[4], NULL, 10) : 4000) / MEMO_GENERATIONS;
+
+    grid dense = create_grid(rows, cols);
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&dense, i, j, rand() % 3 == 0);
+
+    grid mixed = create_grid(rows, cols);
+    memcpy(mixed.words, dense.words, (rows + 2) * dense.row_words * 2 * sizeof(uint64_t));
+    bool same = compare_hybrid(&dense, &mixed, "soup", updates, false, 0);
+
+    const char* pulsar[13] =
+    {
+        "..ooo...ooo..",
+        ".............",
+        "o....o.o....o",
+        "o....o.o....o",
+        "o....o.o....o",
+        "..ooo...ooo..",
+        ".............",
+        "..ooo...ooo..",
+        "o....o.o....o",
+        "o....o.o....o",
+        "o....o.o....o",
+        ".............",
+        "..ooo...ooo..",
+    };
+
+    // Pulsars grow a cell on each side, 18 cells apart they stay apart
+    dense.plane = 0;
+    memset(dense.words, 0, (rows + 2) * dense.row_words * 2 * sizeof(uint64_t));
+    for (size_t row = 2; row + 20 <= rows; row += 18)
+        for (size_t col = 2; col + 16 <= cols; col += 18)
+            for (size_t i = 0; i != 13; ++i)
+                for (size_t j = 0; j != 13; ++j)
+                    set_cell(&dense, row + i, col + j, pulsar[i][j] == 'o');
+
+    for (size_t i = rows - 3; i != rows - 1; ++i)
+        for (size_t j = 2; j != 4; ++j)
+            set_cell(&dense, i, j, true);
+
+    mixed.plane = 0;
+    memcpy(mixed.words, dense.words, (rows + 2) * dense.row_words * 2 * sizeof(uint64_t));
+    same &= compare_hybrid(&dense, &mixed, "pulsars and a block, tile memo first", updates, true, 0);
+
+    // The soup again, leaving the driver every eleventh update, after
+    // a sample has picked an engine, most often the sparse one
+    dense.plane = 0;
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&dense, i, j, rand() % 3 == 0);
+
+    mixed.plane = 0;
+    memcpy(mixed.words, dense.words, (rows + 2) * dense.row_words * 2 * sizeof(uint64_t));
+    same &= compare_hybrid(&dense, &mixed, "soup, other engines in between", updates, false, 11);
+
+    destroy_grid(&mixed);
+    destroy_grid(&dense);
+    return same ? 0 : 1;
+}
+
+// The center of a soup some generations ahead, through its light cone
+// and by advancing the whole grid.
+int
+run_cone_benchmark(int argc,
+                   char** argv)
+{
+    const size_t rows = (argc > 2) ? strtoul(argv[2], NULL, 10) : 4096;
+    const size_t cols = (argc > 3) ? strtoul(argv[3], NULL, 10) : 4096;
+    const size_t generations = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1000;
+    const size_t size = (argc > 5) ? strtoul(argv[5], NULL, 10) : 100;
+    const size_t row = (rows > size) ? (rows - size) / 2 : 0;
+    const size_t col = (cols > size) ? (cols - size) / 2 : 0;
+    const size_t height = (size < rows) ? size : rows;
+    const size_t width = (size < cols) ? size : cols;
+
+    grid g = create_grid(rows, cols);
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&g, i, j, rand() % 3 == 0);
+
+    double start = get_seconds();
+    grid region = future_region(&g, row, col, height, width, generations);
+    const double cone_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&g, g.plane, 0, rows);
+        g.plane = 1 - g.plane;
+    }
+    const double full_time = get_seconds() - start;
+
+    bool same = true;
+    for (size_t i = 0; i != height; ++i)
+        for (size_t j = 0; j != width; ++j)
+            same &= get_cell(&region, i, j) == get_cell(&g, row + i, col + j);
+
+    printf("%zu x %zu region of a %zu x %zu soup, %zu generations ahead, single thread\n",
+           height, width, rows, cols, generations);
+    printf("light cone: %.3f s\n", cone_time);
+    printf("whole grid: %.3f s\n", full_time);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    destroy_grid(&region);
+    destroy_grid(&g);
+    return same ? 0 : 1;
+}
+
+// One generation cell by cell, each cell following the rule of its
+// tile. Slow, the word-wide paths are checked against it.
+void
+step_cells(grid* g)
+{
+    const rule_map* map = g->rule_map;
+    bool* next = malloc(g->rows * g->cols * sizeof(bool));
+
+    for (size_t i = 0; i != g->rows; ++i)
+    {
+        for (size_t j = 0; j != g->cols; ++j)
+        {
+            unsigned neighbors = 0;
+            for (int di = -1; di <= 1; ++di)
+            {
+                for (int dj = -1; dj <= 1; ++dj)
+                {
+                    const int row = (int)i + di;
+                    const int col = (int)j + dj;
+                    if ((di != 0 || dj != 0) &&
+                        row >= 0 && row < (int)g->rows && col >= 0 && col < (int)g->cols)
+                        neighbors += get_cell(g, row, col);
+                }
+            }
+
+            const life_rule* rule = &g->rule;
+            if (map != NULL)
+                rule = &map->rules[map->ids[((g->map_row + i) / RULE_TILE) * map->tile_cols +
+                                            g->map_word + (j + 1) / 64]];
+            const uint16_t mask = get_cell(g, i, j) ? rule->survive : rule->birth;
+            next[i * g->cols + j] = (mask >> neighbors) & 1;
+        }
+    }
+
+    g->plane = 1 - g->plane;
+    for (size_t i = 0; i != g->rows; ++i)
+        for (size_t j = 0; j != g->cols; ++j)
+            set_cell(g, i, j, next[i * g->cols + j]);
+    free(next);
+}
+
+bool
+same_cells(const grid* a,
+           const grid* b)
+{
+    bool same = true;
+    for (size_t i = 0; i != (a->rows + 2) * a->row_words; ++i)
+        same &= a->words[i * 2 + a->plane] == b->words[i * 2 + b->plane];
+    return same;
+}
+
+// A soup on tiles following the given rules at random, stepped cell by
+// cell, one generation at a time on the thread pool, all generations at
+// once through the trapezoids, and by the sparse engine. The light cone
+// of a region not starting on a word is computed from the soup.
+// The whole grid following the first rule is timed against the map.
+int
+run_rule_map_benchmark(int argc,
+                       char** argv)
+{
+    const size_t rows = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1024;
+    const size_t cols = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1024;
+    const size_t generations = (argc > 4) ? strtoul(argv[4], NULL, 10) : 100;
+
+    life_rule rules[RULE_MAP_SIZE];
+    size_t rule_count = 0;
+    for (int i = 5; i < argc && rule_count != RULE_MAP_SIZE; ++i)
+    {
+        if (!parse_rule(argv[i], &rules[rule_count++]))
+        {
+            fprintf(stderr, "usage: %s bench_rule_map [rows] [cols] [generations] <rule>...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (rule_count == 0)
+    {
+        parse_rule("B3/S23", &rules[rule_count++]);
+        parse_rule("B36/S23", &rules[rule_count++]);
+        parse_rule("B3678/S34678", &rules[rule_count++]);
+    }
+
+    grid single = create_grid(rows, cols);
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+        for (size_t j = 0; j != cols; ++j)
+            set_cell(&single, i, j, rand() % 3 == 0);
+
+    grid mapped = create_grid(rows, cols);
+    memcpy(mapped.words, single.words, (rows + 2) * single.row_words * 2 * sizeof(uint64_t));
+    set_grid_rule(&single, &rules[0]);
+    set_grid_rule(&mapped, &rules[0]);
+
+    rule_map map = create_rule_map(&mapped);
+    for (size_t i = 0; i != map.tile_rows; ++i)
+    {
+        for (size_t j = 0; j != map.tile_cols; ++j)
+        {
+            const int id = add_map_rule(&map, &rules[rand() % rule_count]);
+            fill_tile_rules(&map, i, j, i + 1, j + 1, id);
+        }
+    }
+    mapped.rule_map = &map;
+
+    // Copies of the soup, they share the kernels of 'mapped'
+    grid copies[4];
+    for (size_t c = 0; c != 4; ++c)
+    {
+        copies[c] = create_grid_like(&mapped, rows, cols);
+        copy_region(&copies[c], &mapped, 0, 0);
+        copies[c].rule_map = &map;
+    }
+    grid* reference = &copies[0];
+    grid* threaded = &copies[1];
+    grid* walked = &copies[2];
+    grid* sparse = &copies[3];
+
+    const size_t size = 100;
+    const size_t row = rows / 3;
+    const size_t col = cols / 3 + 5;
+    const size_t height = (row + size < rows) ? size : rows - row;
+    const size_t width = (col + size < cols) ? size : cols - col;
+    double start = get_seconds();
+    grid region = future_region(&mapped, row, col, height, width, generations);
+    const double cone_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&single, single.plane, 0, rows);
+        single.plane = 1 - single.plane;
+    }
+    const double single_time = get_seconds() - start;
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_rows(&mapped, mapped.plane, 0, rows);
+        mapped.plane = 1 - mapped.plane;
+    }
+    const double mapped_time = get_seconds() - start;
+
+    thread_info threads = create_threads(threaded);
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid(&threads, threaded, 1);
+    const double threaded_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    threads = create_threads(walked);
+    start = get_seconds();
+    update_grid(&threads, walked, generations);
+    const double walked_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    hybrid_state hybrid = create_hybrid(sparse, NULL);
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        step_sparse(&hybrid, sparse);
+    const double sparse_time = get_seconds() - start;
+    destroy_hybrid(&hybrid);
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        step_cells(reference);
+    const double reference_time = get_seconds() - start;
+
+    const bool mapped_same = same_cells(&mapped, reference);
+    const bool threaded_same = same_cells(threaded, reference);
+    const bool walked_same = same_cells(walked, reference);
+    const bool sparse_same = same_cells(sparse, reference);
+    bool cone_same = true;
+    for (size_t i = 0; i != height; ++i)
+        for (size_t j = 0; j != width; ++j)
+            cone_same &= get_cell(&region, i, j) == get_cell(reference, row + i, col + j);
+    const bool same = mapped_same && threaded_same && walked_same && sparse_same && cone_same;
+
+    const double cells = (double)rows * cols * generations;
+    printf("%zu x %zu, %zu generations, %zu rules, %zu x %zu tiles\n",
+           rows, cols, generations, map.rule_count, map.tile_rows, map.tile_cols);
+    printf("single rule:      %.3f s, %.3f ns/cell\n", single_time, single_time * 1e9 / cells);
+    printf("rule map:         %.3f s, %.3f ns/cell, %s\n",
+           mapped_time, mapped_time * 1e9 / cells, mapped_same ? "match" : "DIFFER");
+    printf("thread pool:      %.3f s, %.3f ns/cell, %s\n",
+           threaded_time, threaded_time * 1e9 / cells, threaded_same ? "match" : "DIFFER");
+    printf("trapezoids:       %.3f s, %.3f ns/cell, %s\n",
+           walked_time, walked_time * 1e9 / cells, walked_same ? "match" : "DIFFER");
+    printf("sparse:           %.3f s, %.3f ns/cell, %s\n",
+           sparse_time, sparse_time * 1e9 / cells, sparse_same ? "match" : "DIFFER");
+    printf("light cone:       %.3f s, %zu x %zu region, %s\n",
+           cone_time, height, width, cone_same ? "match" : "DIFFER");
+    printf("cell by cell:     %.3f s, %.3f ns/cell\n", reference_time, reference_time * 1e9 / cells);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    destroy_grid(&region);
+    for (size_t c = 0; c != 4; ++c)
+        destroy_grid(&copies[c]);
+    destroy_rule_map(&map);
+    destroy_grid(&mapped);
+    destroy_grid(&single);
+    return same ? 0 : 1;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return run_benchmark(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "bench_rule") == 0)
+        return run_rule_benchmark(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "bench_hybrid") == 0)
+        return run_hybrid_benchmark(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "bench_cone") == 0)
+        return run_cone_benchmark(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "bench_rule_map") == 0)
+        return run_rule_map_benchmark(argc, argv);
+
+    life_rule rule;
+    if (argc > 1 && strcmp(argv[1], "rule") == 0 &&
+        (argc < 3 || !parse_rule(argv[2], &rule)))
+    {
+        fprintf(stderr, "usage: %s rule <rule>\n", argv[0]);
+        return 1;
+    }
+
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    if (!sdl_init(&window, &renderer, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return 1;
+
+    grid g = create_grid(CELL_COUNT, CELL_COUNT);
+    if (argc > 1 && strcmp(argv[1], "rule") == 0)
+        set_grid_rule(&g, &rule);
+    thread_info threads = create_threads(&g);
+    memo_state memo = create_memo(&g);
+    hybrid_state hybrid_engine = create_hybrid(&g, &memo);
+
+    bool should_continue = true;
+    bool iterate = false;
+    bool memoize = false;
+    bool hybrid = false;
+    size_t generations = 1;
+    while (should_continue)
+    {
+        bool edited = false;
+        const bool was_hybrid = hybrid;
+        should_continue = handle_events(&g, &iterate, &generations, &memoize, &hybrid, &edited);
+        // The other engines leave the changed words and the other plane stale
+        if (edited || (hybrid && !was_hybrid))
+            reset_hybrid(&hybrid_engine, &g);
+
+        if (iterate && hybrid)
+            update_grid_hybrid(&threads, &hybrid_engine, &g);
+        else if (iterate && memoize)
+            update_grid_memo(&threads, &memo, &g);
+        else if (iterate)
+            update_grid(&threads, &g, generations);
+
+        SDL_RenderClear(renderer);
+        draw_grid(&g, renderer);
+
+        SDL_RenderPresent(renderer);
+
+        SDL_Delay(60);
+    }
+
+    if (memo.lookups != 0)
+        printf("tile memo: %.1f%% hits over %lu lookups, %lu tiles stepped directly\n",
+               memo.hits * 100.0 / memo.lookups,
+               (unsigned long)memo.lookups,
+               (unsigned long)memo.direct);
+
+    if (hybrid_engine.updates != 0)
+        printf("hybrid: %lu dense, %lu sparse, %lu tile memo, %lu periodic generations\n",
+               (unsigned long)hybrid_engine.generations[ENGINE_DENSE],
+               (unsigned long)hybrid_engine.generations[ENGINE_SPARSE],
+               (unsigned long)hybrid_engine.generations[ENGINE_MEMO],
+               (unsigned long)hybrid_engine.generations[ENGINE_PERIODIC]);
+
+    destroy_hybrid(&hybrid_engine);
+    destroy_memo(&memo);
+    destroy_threads(&threads);
+    destroy_grid(&g);
+
+    sdl_shutdown(window, renderer);
+
+    return 0;
+}
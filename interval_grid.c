@@ -0,0 +1,854 @@
+///////////////////////////////////////////////////////////
+/// Interval grid.
+/// Line of thought:
+/// - Layout:
+///     Engineered patterns are mostly long horizontal runs
+///     and empty space, so every row is stored as a sorted
+///     list of its live intervals [begin, end], and a row
+///     costs memory and time for its runs, not its width.
+/// - Kernel:
+///     Along a row the neighbour count of a cell only changes
+///     around the ends of the intervals of the row itself and
+///     the rows above and below: one before, at and after a
+///     begin, and at and up to two after an end.
+///     The next state is worked out once per stretch between
+///     two such points and appended as an interval, so empty
+///     spans and the insides of long runs cost nothing.
+/// - Bounds checking:
+///     Like the other solutions everything outside the
+///     grid is dead.
+/// - Threads:
+///     Rows are written to a second set of rows, so every
+///     thread takes a band of rows without sharing anything.
+///
+/// Benchmark:
+///     ./interval_grid bench [rows] [cols] [generations]
+///     steps a grid of long horizontal lines with a few
+///     blocks, once as intervals and once with the packed
+///     bit kernel, and checks they agree.
+///////////////////////////////////////////////////////////
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BORDER_WIDTH 1
+#define CELL_WIDTH 10
+#define CELL_HEIGHT 10
+#define WINDOW_WIDTH 800
+#define WINDOW_HEIGHT 800
+#define CELL_COUNT (WINDOW_WIDTH / CELL_WIDTH)
+#define THREAD_COUNT 4
+
+int
+sdl_init(SDL_Window** out_window,
+         SDL_Renderer** out_renderer,
+         const int window_width,
+         const int window_height)
+{
+    (*out_window) = NULL;
+    (*out_renderer) = NULL;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        goto failure;
+    }
+
+    (*out_window) = SDL_CreateWindow("interval_conways",
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     window_width,
+                                     window_height,
+                                     SDL_WINDOW_SHOWN);
+
+    if ((*out_window) == NULL)
+    {
+        goto failure;
+    }
+
+    (*out_renderer) = SDL_CreateRenderer((*out_window),
+                                         -1,
+                                         SDL_RENDERER_ACCELERATED);
+
+    if ((*out_renderer) == NULL)
+    {
+        goto failure;
+    }
+
+    return 1;
+
+failure:
+    fprintf(stderr, "SDL_Error: %s\n", SDL_GetError());
+    SDL_DestroyRenderer((*out_renderer));
+    SDL_DestroyWindow((*out_window));
+    return 0;
+}
+
+void
+sdl_shutdown(SDL_Window* window,
+             SDL_Renderer* renderer)
+{
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+///////////////////////////////////////////////////////////
+/// Rows
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    // Sorted begin, end pairs, end included. Intervals never touch,
+    // there is at least one dead cell between two of them.
+    int64_t* intervals;
+    size_t count;
+    size_t capacity;
+} interval_row;
+
+void
+destroy_row(interval_row* row)
+{
+    free(row->intervals);
+    row->intervals = NULL;
+    row->count = 0;
+    row->capacity = 0;
+}
+
+// Appends [begin, end] at the end of a row, merged with the last
+// interval when they touch.
+void
+append_interval(interval_row* row,
+                const int64_t begin,
+                const int64_t end)
+{
+    if (row->count != 0 && row->intervals[row->count * 2 - 1] + 1 >= begin)
+    {
+        row->intervals[row->count * 2 - 1] = end;
+        return;
+    }
+
+    if (row->count == row->capacity)
+    {
+        row->capacity = (row->capacity != 0) ? row->capacity * 2 : 4;
+        row->intervals = realloc(row->intervals, row->capacity * 2 * sizeof(int64_t));
+    }
+    row->intervals[row->count * 2] = begin;
+    row->intervals[row->count * 2 + 1] = end;
+    ++row->count;
+}
+
+// First interval of a row that does not end before x.
+size_t
+find_interval(const interval_row* row,
+              const int64_t x)
+{
+    size_t begin = 0;
+    size_t end = row->count;
+    while (begin != end)
+    {
+        const size_t middle = begin + (end - begin) / 2;
+        if (row->intervals[middle * 2 + 1] < x)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+bool
+row_contains(const interval_row* row,
+             const int64_t x)
+{
+    const size_t idx = find_interval(row, x);
+    return idx != row->count && row->intervals[idx * 2] <= x;
+}
+
+// Sets one cell of a row, splitting or merging intervals as needed.
+void
+row_set(interval_row* row,
+        const int64_t x,
+        const bool val)
+{
+    const size_t idx = find_interval(row, x);
+    const bool alive = idx != row->count && row->intervals[idx * 2] <= x;
+    if (alive == val)
+        return;
+
+    // Rebuild the row, edits are rare compared to generations
+    interval_row rebuilt = {0};
+    for (size_t i = 0; i != row->count; ++i)
+    {
+        const int64_t begin = row->intervals[i * 2];
+        const int64_t end = row->intervals[i * 2 + 1];
+
+        if (i == idx && val)
+        {
+            append_interval(&rebuilt, x, x);
+        }
+        if (i == idx && !val)
+        {
+            if (begin < x)
+                append_interval(&rebuilt, begin, x - 1);
+            if (x < end)
+                append_interval(&rebuilt, x + 1, end);
+            continue;
+        }
+        append_interval(&rebuilt, begin, end);
+    }
+    if (idx == row->count && val)
+        append_interval(&rebuilt, x, x);
+
+    destroy_row(row);
+    (*row) = rebuilt;
+}
+
+///////////////////////////////////////////////////////////
+/// Grid
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    // Current and next rows
+    interval_row* rows[2];
+    size_t current;
+    size_t row_count;
+    size_t col_count;
+} grid;
+
+grid
+create_grid(const size_t rows,
+            const size_t cols)
+{
+    grid g =
+    {
+        .rows =
+        {
+            calloc(rows, sizeof(interval_row)),
+            calloc(rows, sizeof(interval_row)),
+        },
+        .current = 0,
+        .row_count = rows,
+        .col_count = cols,
+    };
+
+    // Set an initial state
+    for (size_t i = 0; i != rows; ++i)
+    {
+        if ((i + 1) % 2 == 0)
+            append_interval(&g.rows[0][i], 0, cols - 1);
+    }
+
+    return g;
+}
+
+void
+destroy_grid(grid* g)
+{
+    for (size_t i = 0; i != g->row_count; ++i)
+    {
+        destroy_row(&g->rows[0][i]);
+        destroy_row(&g->rows[1][i]);
+    }
+    free(g->rows[0]);
+    free(g->rows[1]);
+    g->rows[0] = NULL;
+    g->rows[1] = NULL;
+}
+
+bool
+get_cell(const grid* g,
+         const size_t row,
+         const size_t col)
+{
+    return row_contains(&g->rows[g->current][row], col);
+}
+
+void
+set_cell(grid* g,
+         const size_t row,
+         const size_t col,
+         const bool val)
+{
+    row_set(&g->rows[g->current][row], col, val);
+}
+
+// Smallest point after x where the neighbour count of a cell may change
+// because of this row, INT64_MAX if there is none. `first` moves forward
+// as x grows.
+int64_t
+next_break(const interval_row* row,
+           size_t* first,
+           const int64_t x)
+{
+    const int64_t* intervals = row->intervals;
+    while ((*first) != row->count && intervals[(*first) * 2 + 1] + 2 <= x)
+        ++(*first);
+
+    int64_t best = INT64_MAX;
+    for (size_t i = (*first); i != row->count; ++i)
+    {
+        const int64_t begin = intervals[i * 2];
+        const int64_t end = intervals[i * 2 + 1];
+
+        // Every point of this and later intervals comes after x
+        if (begin - 1 > x)
+            return (begin - 1 < best) ? begin - 1 : best;
+
+        const int64_t points[5] = {begin, begin + 1, end, end + 1, end + 2};
+        for (size_t p = 0; p != 5; ++p)
+        {
+            if (points[p] > x && points[p] < best)
+                best = points[p];
+        }
+    }
+    return best;
+}
+
+// Live cells among columns [x - 1, x + 1] of a row,
+// `first` moves forward as x grows.
+int
+count_window(const interval_row* row,
+             size_t* first,
+             const int64_t x)
+{
+    const int64_t* intervals = row->intervals;
+    while ((*first) != row->count && intervals[(*first) * 2 + 1] < x - 1)
+        ++(*first);
+
+    int live = 0;
+    for (size_t i = (*first); i != row->count && intervals[i * 2] <= x + 1; ++i)
+    {
+        const int64_t begin = (intervals[i * 2] > x - 1) ? intervals[i * 2] : x - 1;
+        const int64_t end = (intervals[i * 2 + 1] < x + 1) ? intervals[i * 2 + 1] : x + 1;
+        live += end - begin + 1;
+    }
+    return live;
+}
+
+// Whether x is alive in a row, `first` moves forward as x grows.
+bool
+interval_contains(const interval_row* row,
+                  size_t* first,
+                  const int64_t x)
+{
+    while ((*first) != row->count && row->intervals[(*first) * 2 + 1] < x)
+        ++(*first);
+    return (*first) != row->count && row->intervals[(*first) * 2] <= x;
+}
+
+// Next state of row y, from the rows around it.
+void
+update_row(const grid* g,
+           const size_t y,
+           interval_row* out)
+{
+    static const interval_row empty = {0};
+    const interval_row* rows[3] =
+    {
+        (y != 0) ? &g->rows[g->current][y - 1] : &empty,
+        &g->rows[g->current][y],
+        (y + 1 != g->row_count) ? &g->rows[g->current][y + 1] : &empty,
+    };
+
+    out->count = 0;
+    if (rows[0]->count == 0 && rows[1]->count == 0 && rows[2]->count == 0)
+        return;
+
+    const int64_t cols = g->col_count;
+    size_t window_firsts[3] = {0, 0, 0};
+    size_t break_firsts[3] = {0, 0, 0};
+    size_t alive_first = 0;
+
+    // Nothing happens before the first break of any row
+    int64_t x = INT64_MAX;
+    for (size_t r = 0; r != 3; ++r)
+    {
+        if (rows[r]->count != 0 && rows[r]->intervals[0] - 1 < x)
+            x = rows[r]->intervals[0] - 1;
+    }
+    if (x < 0)
+        x = 0;
+
+    while (x < cols)
+    {
+        int64_t next = cols;
+        for (size_t r = 0; r != 3; ++r)
+        {
+            const int64_t point = next_break(rows[r], &break_firsts[r], x);
+            if (point < next)
+                next = point;
+        }
+
+        const bool alive = interval_contains(rows[1], &alive_first, x);
+        const int neighbors = count_window(rows[0], &window_firsts[0], x)
+                            + count_window(rows[1], &window_firsts[1], x)
+                            + count_window(rows[2], &window_firsts[2], x)
+                            - alive;
+
+        if (neighbors == 3 || (neighbors == 2 && alive))
+            append_interval(out, x, next - 1);
+
+        x = next;
+    }
+}
+
+///////////////////////////////////////////////////////////
+/// SDL
+///////////////////////////////////////////////////////////
+bool
+handle_events(grid* g,
+              bool* iterate)
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_QUIT ||
+            (event.type == SDL_KEYUP &&
+             event.key.keysym.sym == SDLK_ESCAPE))
+        {
+            return false;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_SPACE)
+        {
+            (*iterate) = !(*iterate);
+        }
+
+        if (event.type == SDL_MOUSEBUTTONUP)
+        {
+            const int selected_col = event.button.x / CELL_WIDTH;
+            const int selected_row = event.button.y / CELL_HEIGHT;
+
+            if (selected_col >= 0 && selected_col < (int)g->col_count &&
+                selected_row >= 0 && selected_row < (int)g->row_count)
+            {
+                set_cell(g, selected_row, selected_col,
+                         !get_cell(g, selected_row, selected_col));
+            }
+        }
+    }
+    return true;
+}
+
+void
+draw_grid(const grid* g,
+          SDL_Renderer* renderer)
+{
+    SDL_Color prev_color;
+    SDL_GetRenderDrawColor(renderer,
+                           &prev_color.r,
+                           &prev_color.g,
+                           &prev_color.b,
+                           &prev_color.a);
+
+    SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
+
+    for (size_t i = 0; i != g->row_count; ++i)
+    {
+        const interval_row* row = &g->rows[g->current][i];
+        for (size_t k = 0; k != row->count; ++k)
+        {
+            for (int64_t j = row->intervals[k * 2]; j <= row->intervals[k * 2 + 1]; ++j)
+            {
+                SDL_Rect rect =
+                {
+                    .x = j * CELL_WIDTH + BORDER_WIDTH,
+                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
+                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
+                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
+                };
+
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer,
+                           prev_color.r,
+                           prev_color.g,
+                           prev_color.b,
+                           prev_color.a);
+}
+
+///////////////////////////////////////////////////////////
+/// Threads
+///////////////////////////////////////////////////////////
+// Contains all information needed by a single thread to run.
+typedef struct
+{
+    grid* g;
+    size_t row_begin;
+    size_t row_end;
+
+    // Synchronization vars
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+} thread_params;
+
+void
+update_band(const thread_params* args)
+{
+    grid* g = args->g;
+    for (size_t y = args->row_begin; y != args->row_end; ++y)
+        update_row(g, y, &g->rows[1 - g->current][y]);
+}
+
+void*
+thread_execution(void* params)
+{
+    thread_params* args = (thread_params*)params;
+    size_t seen = 0;
+    while (true)
+    {
+        pthread_mutex_lock(args->cv_mtx);
+        while (atomic_load_explicit(args->running, memory_order_relaxed) &&
+               atomic_load_explicit(args->generation, memory_order_relaxed) == seen)
+        {
+            pthread_cond_wait(args->cv, args->cv_mtx);
+        }
+        pthread_mutex_unlock(args->cv_mtx);
+
+        if (!atomic_load_explicit(args->running, memory_order_relaxed))
+            break;
+
+        seen = atomic_load_explicit(args->generation, memory_order_acquire);
+        update_band(args);
+
+        atomic_fetch_add_explicit(args->signal, 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Holds all variables that needs to be deallocated,
+// and that is used to communicate between threads.
+typedef struct
+{
+    atomic_bool* running;
+    atomic_size_t* generation;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    pthread_t* threads;
+    thread_params* params;
+} thread_info;
+
+thread_info
+create_threads(grid* g)
+{
+    thread_info info =
+    {
+        .running = malloc(sizeof(atomic_bool)),
+        .generation = malloc(sizeof(atomic_size_t)),
+        .signal = malloc(sizeof(atomic_int)),
+        .cv = malloc(sizeof(pthread_cond_t)),
+        .cv_mtx = malloc(sizeof(pthread_mutex_t)),
+        .threads = malloc((THREAD_COUNT - 1) * sizeof(pthread_t)),
+        .params = malloc((THREAD_COUNT) * sizeof(thread_params)),
+    };
+
+    atomic_init(info.running, true);
+    atomic_init(info.generation, 0);
+    atomic_init(info.signal, 0);
+    pthread_cond_init(info.cv, NULL);
+    pthread_mutex_init(info.cv_mtx, NULL);
+
+    // Initialize threads and start execution
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        info.params[i].g = g;
+        info.params[i].row_begin = (g->row_count * i) / THREAD_COUNT;
+        info.params[i].row_end = (g->row_count * (i + 1)) / THREAD_COUNT;
+        info.params[i].running = info.running;
+        info.params[i].generation = info.generation;
+        info.params[i].signal = info.signal;
+        info.params[i].cv = info.cv;
+        info.params[i].cv_mtx = info.cv_mtx;
+    }
+
+    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
+        pthread_create(&info.threads[i], NULL, thread_execution, &info.params[i + 1]);
+
+    return info;
+}
+
+void
+destroy_threads(thread_info* info)
+{
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_store_explicit(info->running, false, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    for (size_t i = 0; i < THREAD_COUNT - 1; ++i)
+        pthread_join(info->threads[i], NULL);
+
+    pthread_cond_destroy(info->cv);
+    pthread_mutex_destroy(info->cv_mtx);
+    free(info->running);
+    free(info->generation);
+    free(info->signal);
+    free(info->cv);
+    free(info->cv_mtx);
+    free(info->threads);
+    free(info->params);
+}
+
+void
+update_grid(thread_info* info,
+            grid* g)
+{
+    // Awake all threads
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_fetch_add_explicit(info->generation, 1, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    update_band(&info->params[0]);
+
+    int expected = THREAD_COUNT - 1;
+    while (!atomic_compare_exchange_weak_explicit(info->signal,
+                                                  &expected,
+                                                  0,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+    {
+        expected = THREAD_COUNT - 1;
+    }
+
+    g->current = 1 - g->current;
+}
+
+///////////////////////////////////////////////////////////
+/// Benchmark
+///////////////////////////////////////////////////////////
+double
+get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Next state of 64 cells at once, given the 8 words of their
+// neighbours (already shifted into place) and their current state.
+// The neighbour counts are summed bit-sliced through an adder tree,
+// a cell lives if the count is 3, or 2 and it is already alive.
+uint64_t
+life_rule_word(const uint64_t neighbors[8],
+               const uint64_t alive)
+{
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t ones = d_xor ^ c_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t twos = e_sum ^ d_carry;
+    const uint64_t f_carry = e_sum & d_carry;
+
+    return twos & ~(e_carry | f_carry) & (ones | alive);
+}
+
+// The packed bit kernel of the other solutions, for comparison.
+// Rows of row_words words with a dead row above and below, column c
+// is bit c % 64 of word c / 64, bits past the last column stay dead.
+void
+step_packed(uint64_t* restrict dst,
+            const uint64_t* restrict src,
+            const size_t rows,
+            const size_t cols,
+            const size_t row_words)
+{
+    const uint64_t last_mask = (cols % 64 != 0) ? (1ULL << (cols % 64)) - 1 : ~0ULL;
+
+    for (size_t i = 0; i != rows; ++i)
+    {
+        const uint64_t* above = &src[(i + 0) * row_words];
+        const uint64_t* curr = &src[(i + 1) * row_words];
+        const uint64_t* below = &src[(i + 2) * row_words];
+        uint64_t* out = &dst[(i + 1) * row_words];
+
+        for (size_t w = 0; w != row_words; ++w)
+        {
+            const uint64_t first = (w != 0);
+            const uint64_t last = (w + 1 != row_words);
+            const size_t prev = (w != 0) ? w - 1 : w;
+            const size_t next = (w + 1 != row_words) ? w + 1 : w;
+
+            const uint64_t neighbors[8] =
+            {
+                (above[w] << 1) | ((above[prev] >> 63) & first),
+                above[w],
+                (above[w] >> 1) | ((above[next] << 63) & (last << 63)),
+                (curr[w] << 1) | ((curr[prev] >> 63) & first),
+                (curr[w] >> 1) | ((curr[next] << 63) & (last << 63)),
+                (below[w] << 1) | ((below[prev] >> 63) & first),
+                below[w],
+                (below[w] >> 1) | ((below[next] << 63) & (last << 63)),
+            };
+
+            out[w] = life_rule_word(neighbors, curr[w]) & (last ? ~0ULL : last_mask);
+        }
+    }
+}
+
+int
+run_benchmark(int argc,
+              char** argv)
+{
+    const size_t rows = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1024;
+    const size_t cols = (argc > 3) ? strtoul(argv[3], NULL, 10) : 65536;
+    const size_t generations = (argc > 4) ? strtoul(argv[4], NULL, 10) : 100;
+
+    grid g = create_grid(rows, cols);
+    const size_t row_words = (cols + 63) / 64;
+    uint64_t* packed[2] =
+    {
+        calloc((rows + 2) * row_words, sizeof(uint64_t)),
+        calloc((rows + 2) * row_words, sizeof(uint64_t)),
+    };
+
+    // Long lines every 16 rows, and a few blocks between them
+    srand(1);
+    for (size_t i = 0; i != rows; ++i)
+    {
+        destroy_row(&g.rows[0][i]);
+        if (i % 16 == 8 && cols > 32)
+            append_interval(&g.rows[0][i], 16, cols - 16);
+    }
+    for (size_t k = 0; k != rows; ++k)
+    {
+        const size_t i = (rand() % (rows / 16 + 1)) * 16;
+        const size_t j = rand() % cols;
+        for (size_t di = 0; di != 2; ++di)
+        {
+            for (size_t dj = 0; dj != 2; ++dj)
+            {
+                if (i + di < rows && j + dj < cols)
+                    set_cell(&g, i + di, j + dj, true);
+            }
+        }
+    }
+
+    size_t interval_count = 0;
+    for (size_t i = 0; i != rows; ++i)
+    {
+        const interval_row* row = &g.rows[0][i];
+        interval_count += row->count;
+        for (size_t k = 0; k != row->count; ++k)
+        {
+            for (int64_t j = row->intervals[k * 2]; j <= row->intervals[k * 2 + 1]; ++j)
+                packed[0][(i + 1) * row_words + j / 64] |= 1ULL << (j % 64);
+        }
+    }
+
+    thread_info threads = create_threads(&g);
+    double start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid(&threads, &g);
+    const double interval_time = get_seconds() - start;
+    destroy_threads(&threads);
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+    {
+        step_packed(packed[1], packed[0], rows, cols, row_words);
+        uint64_t* tmp = packed[0];
+        packed[0] = packed[1];
+        packed[1] = tmp;
+    }
+    const double packed_time = get_seconds() - start;
+
+    bool same = true;
+    size_t final_count = 0;
+    for (size_t i = 0; i != rows; ++i)
+    {
+        const interval_row* row = &g.rows[g.current][i];
+        final_count += row->count;
+
+        uint64_t* expected = &packed[0][(i + 1) * row_words];
+        uint64_t* got = &packed[1][(i + 1) * row_words];
+        memset(got, 0, row_words * sizeof(uint64_t));
+        for (size_t k = 0; k != row->count; ++k)
+        {
+            for (int64_t j = row->intervals[k * 2]; j <= row->intervals[k * 2 + 1]; ++j)
+                got[j / 64] |= 1ULL << (j % 64);
+        }
+        same &= memcmp(expected, got, row_words * sizeof(uint64_t)) == 0;
+    }
+
+    const double cells = (double)rows * cols * generations;
+    printf("%zu x %zu, %zu generations, %zu intervals at the start, %zu at the end\n",
+           rows, cols, generations, interval_count, final_count);
+    printf("intervals:  %.3f s, %.4f ns/cell\n", interval_time, interval_time * 1e9 / cells);
+    printf("packed:     %.3f s, %.4f ns/cell, single thread\n", packed_time, packed_time * 1e9 / cells);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    free(packed[0]);
+    free(packed[1]);
+    destroy_grid(&g);
+    return same ? 0 : 1;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return run_benchmark(argc, argv);
+
+    SDL_Window* window;
+    SDL_Renderer* renderer;
+    if (!sdl_init(&window, &renderer, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return 1;
+
+    grid g = create_grid(CELL_COUNT, CELL_COUNT);
+    thread_info threads = create_threads(&g);
+
+    bool should_continue = true;
+    bool iterate = false;
+    while (should_continue)
+    {
+        should_continue = handle_events(&g, &iterate);
+
+        if (iterate)
+            update_grid(&threads, &g);
+
+        SDL_RenderClear(renderer);
+        draw_grid(&g, renderer);
+
+        SDL_RenderPresent(renderer);
+
+        SDL_Delay(60);
+    }
+
+    destroy_threads(&threads);
+    destroy_grid(&g);
+
+    sdl_shutdown(window, renderer);
+
+    return 0;
+}
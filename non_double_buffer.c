@@ -32,10 +32,9 @@
 /// -   Can probably add some attributes to help compiler,
 ///     for example, most cells will not be alive, so can
 ///     do a expects solution.
-/// -   Should decide on using int or size_t, unlike C++
-///     size_t doesn't actually give me anything int
-///     doesn't. I had to semi convert to int to get copying
-///     of borders to work, so might as well go all the way.
+/// -   Decided on size_t for sizes and indices, and int64_t
+///     where rows and columns may reach the border at -1,
+///     int indices capped the grid at 2 GiB.
 /// -   Should be consistent on what is macros and what is
 ///     parameters?
 ///     Threads are decided by macro, solutions in functions
@@ -64,16 +63,44 @@
 ///     Solution to avoiding this could be to pad each
 ///     row on both sides.
 ///     But currently I just go for multiple of 8 solution
+///
+/// Benchmark:
+///     ./non_double_buffer bench [generations]
+///     steps a soup with the normal update, two generations at a
+///     time, through the damage pass on the grid alone and in
+///     damage mode, and checks all agree with stepping each grid
+///     on its own.
 /////////////////////////////////////////////////////////////////////
 
+// Needed for O_DIRECT, pwrite and syscall.
+#define _GNU_SOURCE
+
+#include <errno.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
 #include <SDL2/SDL.h>
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define RECORD_USE_IO_URING 1
+#endif
+#endif
+
 #define BORDER_WIDTH 1
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 768
@@ -88,6 +115,38 @@
 
 #define THREAD_COUNT 8
 
+// Frames in flight between the simulation and the disk.
+// O_DIRECT requires buffers, sizes and offsets to be
+// multiples of the logical block size, 4096 covers
+// every device we run on.
+#define RECORD_SLOT_COUNT 8
+#define RECORD_ALIGNMENT 4096
+// Linux caps a single write just below 2 GiB, larger frames are
+// queued in parts of this size, a multiple of the alignment.
+#define RECORD_MAX_WRITE (1U << 30)
+// Submissions the ring may refuse in a row, with no writes in flight,
+// before the recorder gives up on it for pwrite.
+#define RECORD_SUBMIT_TRIES 4
+
+// Snapshots queued for the tracker thread.
+// Components larger than TRACK_MAX_SIZE in either direction are
+// treated as debris and not tracked, and periods longer than
+// TRACK_MAX_PERIOD are not detected.
+#define TRACK_SLOT_COUNT 4
+#define TRACK_MAX_SIZE 32
+#define TRACK_MAX_PERIOD 32
+
+// Largest pattern that can be hashed and identified.
+#define PATTERN_MAX_SIZE 64
+
+// Pieces of one object, in the phases where its cells are not all
+// connected, have at most this many dead rows or columns between them.
+// The exception is two phases of the pentadecathlon, which are not identified.
+#define OBJECT_GAP 2
+
+// 64 bit words per packed row, used by the word wise kernels.
+#define ROW_WORD_COUNT ((CELL_TOT_COL + 63) / 64)
+
 #if ((CELL_TOT_COL) % 8 != 0)
 #error "CELL_TOT_COL is not multiple of 8"
 #endif
@@ -96,29 +155,47 @@
 #error "CELL_ROW_COUNT is not multiple of THREAD_COUNT"
 #endif
 
+// Tiles used for population summaries.
+// Tile columns are aligned to the packed bytes,
+// so they are counted in outer columns (including the border).
+#define TILE_SIZE 16
+#define TILE_ROW_COUNT (CELL_ROW_COUNT / TILE_SIZE)
+#define TILE_COL_COUNT (CELL_TOT_COL / TILE_SIZE)
+
+#if ((CELL_TOT_COL) % TILE_SIZE != 0)
+#error "CELL_TOT_COL is not multiple of TILE_SIZE"
+#endif
+
+// Each thread must own whole tile rows to update their counts without races.
+#if ((CELL_ROW_COUNT / THREAD_COUNT) % TILE_SIZE != 0)
+#error "Rows per thread is not multiple of TILE_SIZE"
+#endif
+
 ///////////////////////////////////////////////////////////
 /// Grid
 ///////////////////////////////////////////////////////////
 typedef uint8_t cell;
 
+// Rows and columns are signed, the border is at -1,
+// and 64 bit so grids past 2 GiB can be indexed.
 size_t
-get_byte_idx(const int row,
-             const int col)
+get_byte_idx(const int64_t row,
+             const int64_t col)
 {
-    const int row_idx = (row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
-    const int row_byte = (col + CELL_COL_OFFSET) / 8;
+    const size_t row_idx = (size_t)(row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
+    const size_t row_byte = (size_t)(col + CELL_COL_OFFSET) / 8;
     return row_idx + row_byte;
 }
 
 void
 set_cell(cell* grid,
-         const int row,
-         const int col,
+         const int64_t row,
+         const int64_t col,
          bool val)
 {
-    const int row_idx = (row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
-    const int row_byte = (col + CELL_COL_OFFSET) / 8;
-    const int byte_idx = row_idx + row_byte;
+    const size_t row_idx = (size_t)(row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
+    const size_t row_byte = (size_t)(col + CELL_COL_OFFSET) / 8;
+    const size_t byte_idx = row_idx + row_byte;
 
     // Conditionally skipping one bit if we are in byte which has border
     const int bit_idx = (col + (row_byte != 0)) % 8 + (row_byte == 0);
@@ -131,12 +208,12 @@ set_cell(cell* grid,
 
 bool
 get_cell(const cell* grid,
-         const int row,
-         const int col)
+         const int64_t row,
+         const int64_t col)
 {
-    const int row_idx = (row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
-    const int row_byte = (col + CELL_COL_OFFSET) / 8;
-    const int byte_idx = row_idx + row_byte;
+    const size_t row_idx = (size_t)(row + CELL_ROW_OFFSET) * (CELL_TOT_COL / 8);
+    const size_t row_byte = (size_t)(col + CELL_COL_OFFSET) / 8;
+    const size_t byte_idx = row_idx + row_byte;
     const int bit_idx = (col + (row_byte != 0)) % 8 + (row_byte == 0);
 
     return grid[byte_idx] & (1 << bit_idx);
@@ -144,9 +221,9 @@ get_cell(const cell* grid,
 
 bool
 get_cell_from_row(const cell* row,
-                  const int col)
+                  const int64_t col)
 {
-    const int row_byte = (col + CELL_COL_OFFSET) / 8;
+    const size_t row_byte = (size_t)(col + CELL_COL_OFFSET) / 8;
     const int bit_idx = (col + (row_byte != 0)) % 8 + (row_byte == 0);
     return row[row_byte] & (1 << bit_idx);
 }
@@ -156,7 +233,7 @@ copy_row(cell* restrict dst,
          const cell* restrict src,
          const size_t cols)
 {
-    int size = (cols + CELL_COL_OFFSET * 2) / 8;
+    const size_t size = (cols + CELL_COL_OFFSET * 2) / 8;
     memcpy(dst, src, size);
 }
 
@@ -168,6 +245,98 @@ create_row(const size_t cols)
     return calloc(outer_cols, sizeof(cell));
 }
 
+// Bools, one per byte, are packed 8 at a time. Each 8 bools are
+// loaded as one word, and their low bits gathered into a byte
+// (or spread back out of one) with a few word operations instead
+// of 8 shifts. BMI2 does the gather and spread in one instruction
+// (build with -march=native).
+uint8_t
+pack_cells_8(const bool* cells)
+{
+    uint64_t bytes;
+    memcpy(&bytes, cells, 8);
+#if defined(__BMI2__)
+    return _pext_u64(bytes, 0x0101010101010101ULL);
+#else
+    // Byte k of the bools lands on bit 56 + k of the product.
+    return (bytes * 0x0102040810204080ULL) >> 56;
+#endif
+}
+
+void
+unpack_cells_8(bool* cells,
+               const uint8_t bits)
+{
+#if defined(__BMI2__)
+    const uint64_t bytes = _pdep_u64(bits, 0x0101010101010101ULL);
+#else
+    // A copy of the bits in every byte, byte k keeps bit k,
+    // and adding 0x7F carries any set bit into the top bit.
+    const uint64_t spread = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    const uint64_t bytes = ((spread + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+#endif
+    memcpy(cells, &bytes, 8);
+}
+
+// Packs 'cols' bools into the inner columns of a row.
+// The row is cleared first, so the border stays dead.
+void
+pack_row(cell* restrict row,
+         const bool* restrict cells,
+         const size_t cols)
+{
+    const size_t row_bytes = (cols + CELL_COL_OFFSET * 2) / 8;
+    memset(row, 0, row_bytes);
+
+    for (size_t j = 0; j < cols; j += 8)
+    {
+        uint8_t bits;
+        if (cols - j >= 8)
+        {
+            bits = pack_cells_8(&cells[j]);
+        }
+        else
+        {
+            bool tail[8] = {0};
+            memcpy(tail, &cells[j], cols - j);
+            bits = pack_cells_8(tail);
+        }
+
+        // Inner column j is outer column j + CELL_COL_OFFSET
+        const size_t byte = j / 8;
+        row[byte] |= bits << CELL_COL_OFFSET;
+        if (byte + 1 < row_bytes)
+            row[byte + 1] |= bits >> (8 - CELL_COL_OFFSET);
+    }
+}
+
+// Unpacks the inner columns of a row into 'cols' bools.
+void
+unpack_row(bool* restrict cells,
+           const cell* restrict row,
+           const size_t cols)
+{
+    const size_t row_bytes = (cols + CELL_COL_OFFSET * 2) / 8;
+
+    for (size_t j = 0; j < cols; j += 8)
+    {
+        const size_t byte = j / 8;
+        const uint8_t high = (byte + 1 < row_bytes) ? row[byte + 1] : 0;
+        const uint8_t bits = (row[byte] >> CELL_COL_OFFSET) | (high << (8 - CELL_COL_OFFSET));
+
+        if (cols - j >= 8)
+        {
+            unpack_cells_8(&cells[j], bits);
+        }
+        else
+        {
+            bool tail[8];
+            unpack_cells_8(tail, bits);
+            memcpy(&cells[j], tail, cols - j);
+        }
+    }
+}
+
 // Kept for debug purposes.
 void
 print_row(cell* row,
@@ -184,11 +353,83 @@ print_row(cell* row,
     printf("\n");
 }
 
+// Next state of 64 cells at once, given the 8 words of their
+// neighbours (already shifted into place) and their current state.
+// The neighbour counts are summed bit-sliced through an adder tree,
+// a cell lives if the count is 3, or 2 and it is already alive.
+uint64_t
+life_rule_word(const uint64_t neighbors[8],
+               const uint64_t alive)
+{
+    // Three full adders and a half adder give the ones and twos
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t ones = d_xor ^ c_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    // Twos, anything carried past them means 4 or more neighbours
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t twos = e_sum ^ d_carry;
+    const uint64_t f_carry = e_sum & d_carry;
+
+    return twos & ~(e_carry | f_carry) & (ones | alive);
+}
+
+// Counts live cells in the outer columns [bit_begin, bit_end) of a row.
+uint32_t
+count_row_bits(const cell* row,
+               const size_t bit_begin,
+               const size_t bit_end)
+{
+    uint32_t count = 0;
+    for (size_t bit = bit_begin; bit < bit_end;)
+    {
+        const size_t byte = bit / 8;
+        const size_t first = bit % 8;
+        const size_t last = (bit_end - byte * 8 < 8) ? bit_end - byte * 8 : 8;
+        const uint8_t mask = (uint8_t)((0xFF >> (8 - (last - first))) << first);
+
+        count += __builtin_popcount(row[byte] & mask);
+        bit = byte * 8 + last;
+    }
+    return count;
+}
+
+// Adds the population of a row to the tiles it belongs to.
+void
+add_row_to_tiles(uint32_t* restrict tile_pop,
+                 const cell* restrict grid,
+                 const size_t row)
+{
+    const cell* row_ptr = &grid[get_byte_idx(row, -1)];
+    uint32_t* tile_row = &tile_pop[(row / TILE_SIZE) * TILE_COL_COUNT];
+
+    for (size_t i = 0; i != TILE_COL_COUNT; ++i)
+    {
+        for (size_t j = 0; j != TILE_SIZE / 8; ++j)
+            tile_row[i] += __builtin_popcount(row_ptr[i * (TILE_SIZE / 8) + j]);
+    }
+}
+
 void*
 sub_update(cell* restrict grid,
            cell* restrict above,
            cell* restrict curr,
            cell* restrict border,
+           uint32_t* restrict tile_pop,
            size_t row_begin,
            size_t row_end,
            size_t cols,
@@ -200,6 +441,10 @@ sub_update(cell* restrict grid,
     // Any live cell with more than three live neighbours dies, as if by overpopulation.
     // Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
 
+    // Tile populations are recounted as the new rows are written.
+    memset(&tile_pop[(row_begin / TILE_SIZE) * TILE_COL_COUNT], 0,
+           ((row_end - row_begin) / TILE_SIZE) * TILE_COL_COUNT * sizeof(uint32_t));
+
     for (size_t i = row_begin; i != row_end; ++i)
     {
         copy_row(curr, &grid[get_byte_idx(i, -1)], cols);
@@ -241,6 +486,7 @@ sub_update(cell* restrict grid,
 
         }
 
+        add_row_to_tiles(tile_pop, grid, i);
         copy_row(above, curr, cols);
     }
 
@@ -260,324 +506,3010 @@ create_grid(const size_t rows,
     cell* grid = calloc(outer_rows * outer_cols, sizeof(cell));
 
     // Set an initial state
+    bool* cells = malloc(cols * sizeof(bool));
     for (size_t i = 0; i != rows; ++i)
     {
-        for (size_t j = 0; j != cols; ++j)
-        {
-            set_cell(grid, i, j, ((i - 1) % 2 == 0));
-        }
+        memset(cells, ((i - 1) % 2 == 0), cols * sizeof(bool));
+        pack_row(&grid[get_byte_idx(i, -1)], cells, cols);
     }
+    free(cells);
 
     return grid;
 }
 
 ///////////////////////////////////////////////////////////
-/// SDL
+/// Tiles
 ///////////////////////////////////////////////////////////
-int
-sdl_init(SDL_Window** out_window,
-         SDL_Renderer** out_renderer,
-         const int window_width,
-         const int window_height)
+// Per tile populations are recounted by sub_update while stepping,
+// and kept up to date by edits.
+// After each generation a summed-area table over the tiles is built,
+// so region queries only scan the partial tiles on the region edges.
+typedef struct
 {
-    (*out_window) = NULL;
-    (*out_renderer) = NULL;
-
-    if (SDL_Init(SDL_INIT_VIDEO) < 0)
-    {
-        goto failure;
-    }
-
-    (*out_window) = SDL_CreateWindow("non_double_buffered_conways",
-                                     SDL_WINDOWPOS_UNDEFINED,
-                                     SDL_WINDOWPOS_UNDEFINED,
-                                     window_width,
-                                     window_height,
-                                     SDL_WINDOW_SHOWN);
+    uint32_t* pop;
+    // (TILE_ROW_COUNT + 1) * (TILE_COL_COUNT + 1) entries,
+    // sat[r][c] is the population of all tiles above and left of (r, c).
+    uint64_t* sat;
+} tile_summary;
 
-    if ((*out_window) == NULL)
+void
+build_summed_area(tile_summary* tiles)
+{
+    const size_t stride = TILE_COL_COUNT + 1;
+    for (size_t i = 0; i != TILE_ROW_COUNT; ++i)
     {
-        goto failure;
+        uint64_t row_sum = 0;
+        for (size_t j = 0; j != TILE_COL_COUNT; ++j)
+        {
+            row_sum += tiles->pop[i * TILE_COL_COUNT + j];
+            tiles->sat[(i + 1) * stride + (j + 1)] = tiles->sat[i * stride + (j + 1)] + row_sum;
+        }
     }
+}
 
-    (*out_renderer) = SDL_CreateRenderer((*out_window),
-                                         -1,
-                                         SDL_RENDERER_ACCELERATED);
-
-    if ((*out_renderer) == NULL)
+tile_summary
+create_tile_summary(const cell* grid)
+{
+    tile_summary tiles =
     {
-        goto failure;
-    }
+        .pop = calloc(TILE_ROW_COUNT * TILE_COL_COUNT, sizeof(uint32_t)),
+        .sat = calloc((TILE_ROW_COUNT + 1) * (TILE_COL_COUNT + 1), sizeof(uint64_t)),
+    };
 
-    return 1;
+    for (size_t i = 0; i != CELL_ROW_COUNT; ++i)
+        add_row_to_tiles(tiles.pop, grid, i);
 
-failure:
-    fprintf(stderr, "SDL_Error: %s\n", SDL_GetError());
-    SDL_DestroyRenderer((*out_renderer));
-    SDL_DestroyWindow((*out_window));
-    return 0;
+    build_summed_area(&tiles);
+    return tiles;
 }
 
 void
-sdl_shutdown(SDL_Window* window,
-             SDL_Renderer* renderer)
+destroy_tile_summary(tile_summary* tiles)
 {
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    free(tiles->pop);
+    free(tiles->sat);
 }
 
-bool
-handle_events(cell* grid,
-              const size_t rows,
-              const size_t cols,
-              bool* iterate)
+// Keeps the summary in sync with a single cell edit.
+void
+set_cell_tracked(cell* grid,
+                 tile_summary* tiles,
+                 const int64_t row,
+                 const int64_t col,
+                 bool val)
 {
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
-    {
-        if (event.type == SDL_QUIT ||
-            (event.type == SDL_KEYUP &&
-             event.key.keysym.sym == SDLK_ESCAPE))
-        {
-            return false;
-        }
+    const bool old_val = get_cell(grid, row, col);
+    if (old_val == val)
+        return;
 
-        if (event.type == SDL_KEYUP &&
-            event.key.keysym.sym == SDLK_SPACE)
-        {
-            (*iterate) = !(*iterate);
-        }
+    set_cell(grid, row, col, val);
 
-        if (event.type == SDL_MOUSEBUTTONUP)
-        {
-            const int selected_col = event.button.x / CELL_WIDTH;
-            const int selected_row = event.button.y / CELL_HEIGHT;
+    const size_t tile_row = row / TILE_SIZE;
+    const size_t tile_col = (col + CELL_COL_OFFSET) / TILE_SIZE;
+    tiles->pop[tile_row * TILE_COL_COUNT + tile_col] += val ? 1 : -1;
 
-            if (selected_col >= 0 && selected_col < (int)cols &&
-                selected_row >= 0 && selected_row < (int)rows)
-            {
-                bool val = get_cell(grid, selected_row, selected_col);
-                set_cell(grid, selected_row, selected_col, !val);
-            }
+    // Only the sums covering the tile change, those below and right of it.
+    const size_t stride = TILE_COL_COUNT + 1;
+    for (size_t i = tile_row + 1; i != TILE_ROW_COUNT + 1; ++i)
+    {
+        for (size_t j = tile_col + 1; j != TILE_COL_COUNT + 1; ++j)
+        {
+            if (val)
+                tiles->sat[i * stride + j]++;
+            else
+                tiles->sat[i * stride + j]--;
         }
     }
-    return true;
 }
 
-void
-draw_grid(cell* grid,
-          const size_t rows,
-          const size_t cols,
-          SDL_Renderer* renderer)
+// Population of whole tiles in [tile_row_begin, tile_row_end) x [tile_col_begin, tile_col_end).
+uint64_t
+count_tiles(const tile_summary* tiles,
+            const size_t tile_row_begin,
+            const size_t tile_col_begin,
+            const size_t tile_row_end,
+            const size_t tile_col_end)
 {
-    SDL_Color prev_color;
-    SDL_GetRenderDrawColor(renderer,
-                           &prev_color.r,
-                           &prev_color.g,
-                           &prev_color.b,
-                           &prev_color.a);
+    const size_t stride = TILE_COL_COUNT + 1;
+    return tiles->sat[tile_row_end * stride + tile_col_end]
+         - tiles->sat[tile_row_begin * stride + tile_col_end]
+         - tiles->sat[tile_row_end * stride + tile_col_begin]
+         + tiles->sat[tile_row_begin * stride + tile_col_begin];
+}
 
-    SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
+// Scans the cells in [row_begin, row_end) x [bit_begin, bit_end), in outer columns.
+uint64_t
+count_cells(const cell* grid,
+            const size_t row_begin,
+            const size_t bit_begin,
+            const size_t row_end,
+            const size_t bit_end)
+{
+    uint64_t count = 0;
+    for (size_t i = row_begin; i < row_end; ++i)
+        count += count_row_bits(&grid[get_byte_idx(i, -1)], bit_begin, bit_end);
+    return count;
+}
 
-    for (size_t i = 0; i != rows; ++i)
-    {
-        for (size_t j = 0; j != cols; ++j)
-        {
-            if (get_cell(grid, i, j))
-            {
-                SDL_Rect rect =
-                {
-                    .x = j * CELL_WIDTH + BORDER_WIDTH,
-                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
-                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
-                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
-                };
+// Live cells in [row_begin, row_end) x [col_begin, col_end).
+// Whole tiles are answered by the summed-area table,
+// only the strips along the edges of the region are scanned.
+uint64_t
+count_region(const cell* grid,
+             const tile_summary* tiles,
+             const size_t row_begin,
+             const size_t col_begin,
+             const size_t row_end,
+             const size_t col_end)
+{
+    if (row_begin >= row_end || col_begin >= col_end)
+        return 0;
 
-                SDL_RenderFillRect(renderer, &rect);
-            }
-        }
-    }
+    const size_t bit_begin = col_begin + CELL_COL_OFFSET;
+    const size_t bit_end = col_end + CELL_COL_OFFSET;
 
-    SDL_SetRenderDrawColor(renderer,
-                           prev_color.r,
-                           prev_color.g,
-                           prev_color.b,
-                           prev_color.a);
+    const size_t tile_row_begin = (row_begin + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tile_row_end = row_end / TILE_SIZE;
+    const size_t tile_col_begin = (bit_begin + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tile_col_end = bit_end / TILE_SIZE;
+
+    if (tile_row_begin >= tile_row_end || tile_col_begin >= tile_col_end)
+        return count_cells(grid, row_begin, bit_begin, row_end, bit_end);
+
+    const size_t inner_row_begin = tile_row_begin * TILE_SIZE;
+    const size_t inner_row_end = tile_row_end * TILE_SIZE;
+    const size_t inner_bit_begin = tile_col_begin * TILE_SIZE;
+    const size_t inner_bit_end = tile_col_end * TILE_SIZE;
+
+    uint64_t count = count_tiles(tiles, tile_row_begin, tile_col_begin,
+                                 tile_row_end, tile_col_end);
+
+    // Top and bottom strips, full width
+    count += count_cells(grid, row_begin, bit_begin, inner_row_begin, bit_end);
+    count += count_cells(grid, inner_row_end, bit_begin, row_end, bit_end);
+
+    // Left and right strips, between the top and bottom strips
+    count += count_cells(grid, inner_row_begin, bit_begin, inner_row_end, inner_bit_begin);
+    count += count_cells(grid, inner_row_begin, inner_bit_end, inner_row_end, bit_end);
+
+    return count;
+}
+
+bool
+is_region_empty(const cell* grid,
+                const tile_summary* tiles,
+                const size_t row_begin,
+                const size_t col_begin,
+                const size_t row_end,
+                const size_t col_end)
+{
+    return count_region(grid, tiles, row_begin, col_begin, row_end, col_end) == 0;
+}
+
+void
+print_population(const cell* grid,
+                 const tile_summary* tiles,
+                 const size_t rows,
+                 const size_t cols)
+{
+    printf("population: %lu\n",
+           (unsigned long)count_region(grid, tiles, 0, 0, rows, cols));
+
+    const size_t half_rows = rows / 2;
+    const size_t half_cols = cols / 2;
+    printf("quadrants: %lu %lu %lu %lu\n",
+           (unsigned long)count_region(grid, tiles, 0, 0, half_rows, half_cols),
+           (unsigned long)count_region(grid, tiles, 0, half_cols, half_rows, cols),
+           (unsigned long)count_region(grid, tiles, half_rows, 0, rows, half_cols),
+           (unsigned long)count_region(grid, tiles, half_rows, half_cols, rows, cols));
 }
 
 ///////////////////////////////////////////////////////////
-/// Threads
+/// Components
 ///////////////////////////////////////////////////////////
-// Contains all information needed by a single thread to run.
+// Connected components of live cells (8-connectivity),
+// labeled over horizontal runs rather than single cells.
+// Each thread extracts the runs of one band and unions
+// them with the runs of the row above, afterwards the
+// bands are merged along their shared borders.
 typedef struct
 {
-    cell* restrict grid;
+    size_t row;
+    // Outer columns, [begin, end)
+    size_t begin;
+    size_t end;
+    // Component index, valid after labeling.
+    size_t label;
+} cell_run;
+
+typedef struct
+{
+    // Bounding box in grid coordinates, [begin, end)
     size_t row_begin;
     size_t row_end;
-    size_t cols;
+    size_t col_begin;
+    size_t col_end;
+    size_t population;
+} component;
 
-    cell* restrict above_buffer;
-    cell* restrict current_buffer;
-    cell* restrict border_buffer;
+typedef struct
+{
+    cell_run* runs;
+    size_t run_count;
+    component* components;
+    size_t component_count;
+} component_labels;
+
+// Loads 64 outer columns of a row, starting at word * 64.
+uint64_t
+load_row_word(const cell* row,
+              const size_t word,
+              const size_t row_bytes)
+{
+    uint64_t val = 0;
+    const size_t offset = word * 8;
+    const size_t size = (row_bytes - offset < 8) ? row_bytes - offset : 8;
+    memcpy(&val, row + offset, size);
+    return val;
+}
 
-    // Synchronization vars
-    atomic_bool* running;
-    atomic_int* signal;
-    pthread_cond_t* cv;
-    pthread_mutex_t* cv_mtx;
+size_t
+find_root(size_t* parent,
+          size_t i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
 
-    size_t id;
-} thread_params;
+void
+union_roots(size_t* parent,
+            const size_t a,
+            const size_t b)
+{
+    const size_t root_a = find_root(parent, a);
+    const size_t root_b = find_root(parent, b);
+
+    // Lowest index wins, keeps labels stable in scan order.
+    if (root_a < root_b)
+        parent[root_b] = root_a;
+    else if (root_b < root_a)
+        parent[root_a] = root_b;
+}
 
-void*
-thread_execution(void* params)
+// Unions the runs of two vertically adjacent rows,
+// both ranges sorted by column.
+void
+connect_rows(size_t* parent,
+             const cell_run* runs,
+             size_t above_begin,
+             const size_t above_end,
+             size_t curr_begin,
+             const size_t curr_end)
 {
-    thread_params* args = (thread_params*)params;
-    while (atomic_load_explicit(args->running,
-                                memory_order_relaxed))
+    while (above_begin != above_end && curr_begin != curr_end)
     {
-        pthread_mutex_lock(args->cv_mtx);
-        pthread_cond_wait(args->cv, args->cv_mtx);
-        pthread_mutex_unlock(args->cv_mtx);
+        const cell_run* above = &runs[above_begin];
+        const cell_run* curr = &runs[curr_begin];
 
-        sub_update(args->grid, args->above_buffer,
-                   args->current_buffer, args->border_buffer,
-                   args->row_begin, args->row_end,
-                   args->cols, args->id);
+        // Diagonal neighbours touch as well
+        if (above->begin <= curr->end && curr->begin <= above->end)
+            union_roots(parent, above_begin, curr_begin);
 
-        atomic_fetch_add_explicit(args->signal, 1, memory_order_release);
+        if (above->end < curr->end)
+            ++above_begin;
+        else
+            ++curr_begin;
     }
-
-    return NULL;
 }
 
-// Holds all variables that needs to be deallocated,
-// and that is used to communicate between threads.
-// This structure should be merged together with thread_params.
 typedef struct
 {
-    atomic_bool* running;
-    atomic_int* signal;
-    pthread_cond_t* cv;
-    pthread_mutex_t* cv_mtx;
-    pthread_t* threads;
-    thread_params* params;
-} thread_info;
+    const cell* grid;
+    size_t row_begin;
+    size_t row_end;
+    size_t cols;
 
-thread_info
-create_threads(cell* restrict grid,
+    cell_run* runs;
+    size_t run_count;
+    size_t run_capacity;
+    size_t* parent;
+    size_t parent_capacity;
+} label_params;
+
+void
+push_run(label_params* band,
+         const size_t row,
+         const size_t begin,
+         const size_t end)
+{
+    if (band->run_count == band->run_capacity)
+    {
+        band->run_capacity = band->run_capacity ? band->run_capacity * 2 : 64;
+        band->runs = realloc(band->runs, band->run_capacity * sizeof(cell_run));
+    }
+
+    band->runs[band->run_count++] = (cell_run)
+    {
+        .row = row,
+        .begin = begin,
+        .end = end,
+    };
+}
+
+void*
+label_band(void* params)
+{
+    label_params* band = (label_params*)params;
+    const size_t row_bytes = (band->cols + CELL_COL_OFFSET * 2) / 8;
+    const size_t words = (row_bytes + 7) / 8;
+
+    size_t above_begin = 0;
+    size_t above_end = 0;
+
+    for (size_t i = band->row_begin; i != band->row_end; ++i)
+    {
+        const cell* row = &band->grid[get_byte_idx(i, -1)];
+        const size_t curr_begin = band->run_count;
+
+        for (size_t w = 0; w != words; ++w)
+        {
+            uint64_t bits = load_row_word(row, w, row_bytes);
+            while (bits)
+            {
+                const size_t start = __builtin_ctzll(bits);
+                const uint64_t shifted = ~(bits >> start);
+                const size_t length = shifted ? (size_t)__builtin_ctzll(shifted) : 64 - start;
+
+                const size_t begin = w * 64 + start;
+                const size_t end = begin + length;
+
+                // Runs crossing a word border are joined
+                if (band->run_count != curr_begin &&
+                    band->runs[band->run_count - 1].end == begin)
+                    band->runs[band->run_count - 1].end = end;
+                else
+                    push_run(band, i, begin, end);
+
+                bits = (length + start == 64) ? 0 : bits & (~0ULL << (start + length));
+            }
+        }
+
+        if (band->parent_capacity < band->run_capacity)
+        {
+            band->parent_capacity = band->run_capacity;
+            band->parent = realloc(band->parent, band->parent_capacity * sizeof(size_t));
+        }
+
+        for (size_t r = curr_begin; r != band->run_count; ++r)
+            band->parent[r] = r;
+
+        // The above range is empty for the first row of the band,
+        // that border is merged after all bands are done.
+        connect_rows(band->parent, band->runs,
+                     above_begin, above_end,
+                     curr_begin, band->run_count);
+
+        above_begin = curr_begin;
+        above_end = band->run_count;
+    }
+
+    return NULL;
+}
+
+// Splits the rows into band_count bands, labeled in parallel.
+// band_count must be at most THREAD_COUNT.
+component_labels
+label_components(const cell* grid,
+                 const size_t rows,
+                 const size_t cols,
+                 const size_t band_count)
+{
+    pthread_t threads[THREAD_COUNT - 1];
+    label_params bands[THREAD_COUNT];
+    memset(bands, 0, sizeof(bands));
+
+    for (size_t i = 0; i != band_count; ++i)
+    {
+        bands[i].grid = grid;
+        bands[i].row_begin = (rows / band_count) * i;
+        bands[i].row_end = (i + 1 == band_count) ? rows : (rows / band_count) * (i + 1);
+        bands[i].cols = cols;
+    }
+
+    for (size_t i = 0; i != band_count - 1; ++i)
+        pthread_create(&threads[i], NULL, label_band, &bands[i + 1]);
+
+    label_band(&bands[0]);
+
+    for (size_t i = 0; i != band_count - 1; ++i)
+        pthread_join(threads[i], NULL);
+
+    // Gather the bands into one run list and one union-find forest
+    size_t offsets[THREAD_COUNT + 1] = {0};
+    for (size_t i = 0; i != band_count; ++i)
+        offsets[i + 1] = offsets[i] + bands[i].run_count;
+
+    component_labels labels =
+    {
+        .runs = malloc((offsets[band_count] + 1) * sizeof(cell_run)),
+        .run_count = offsets[band_count],
+    };
+    size_t* parent = malloc((labels.run_count + 1) * sizeof(size_t));
+
+    for (size_t i = 0; i != band_count; ++i)
+    {
+        if (bands[i].run_count != 0)
+            memcpy(&labels.runs[offsets[i]], bands[i].runs,
+                   bands[i].run_count * sizeof(cell_run));
+
+        for (size_t r = 0; r != bands[i].run_count; ++r)
+            parent[offsets[i] + r] = bands[i].parent[r] + offsets[i];
+
+        free(bands[i].runs);
+        free(bands[i].parent);
+    }
+
+    // Merge along the band borders,
+    // last row of one band against the first row of the next.
+    for (size_t i = 1; i != band_count; ++i)
+    {
+        const size_t border_row = bands[i].row_begin;
+
+        size_t above_begin = offsets[i];
+        while (above_begin != offsets[i - 1] &&
+               labels.runs[above_begin - 1].row == border_row - 1)
+            --above_begin;
+
+        size_t curr_end = offsets[i];
+        while (curr_end != offsets[i + 1] &&
+               labels.runs[curr_end].row == border_row)
+            ++curr_end;
+
+        connect_rows(parent, labels.runs,
+                     above_begin, offsets[i],
+                     offsets[i], curr_end);
+    }
+
+    // Roots become component indices in scan order
+    labels.components = malloc((labels.run_count + 1) * sizeof(component));
+    for (size_t r = 0; r != labels.run_count; ++r)
+    {
+        cell_run* run = &labels.runs[r];
+        const size_t root = find_root(parent, r);
+        const size_t col_begin = run->begin - CELL_COL_OFFSET;
+        const size_t col_end = run->end - CELL_COL_OFFSET;
+
+        if (root == r)
+        {
+            run->label = labels.component_count++;
+            labels.components[run->label] = (component)
+            {
+                .row_begin = run->row,
+                .row_end = run->row + 1,
+                .col_begin = col_begin,
+                .col_end = col_end,
+                .population = 0,
+            };
+        }
+        else
+        {
+            run->label = labels.runs[root].label;
+        }
+
+        component* comp = &labels.components[run->label];
+        comp->row_end = run->row + 1;
+        comp->col_begin = (col_begin < comp->col_begin) ? col_begin : comp->col_begin;
+        comp->col_end = (col_end > comp->col_end) ? col_end : comp->col_end;
+        comp->population += run->end - run->begin;
+    }
+
+    free(parent);
+    return labels;
+}
+
+void
+destroy_component_labels(component_labels* labels)
+{
+    free(labels->runs);
+    free(labels->components);
+}
+
+///////////////////////////////////////////////////////////
+/// Patterns
+///////////////////////////////////////////////////////////
+// Small patterns (up to 64 x 64) stored as one word per row,
+// bit j of rows[i] is the cell at row i, column j.
+// Patterns are kept cropped to their bounding box.
+//
+// The canonical hash is the smallest hash over the 8 rotations
+// and reflections, so every orientation of an object hashes the same.
+// Known objects are stored by the canonical hash of every phase,
+// making identification a single table lookup.
+// Objects whose phases fall apart are matched by grouping the
+// nearby components, see identify_component.
+typedef struct
+{
+    uint64_t rows[PATTERN_MAX_SIZE];
+    size_t width;
+    size_t height;
+} pattern;
+
+uint64_t
+hash_combine(uint64_t hash,
+             const uint64_t val)
+{
+    hash ^= val + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0x100000001B3ULL;
+}
+
+uint64_t
+reverse_bits(uint64_t val)
+{
+    val = ((val >> 1) & 0x5555555555555555ULL) | ((val & 0x5555555555555555ULL) << 1);
+    val = ((val >> 2) & 0x3333333333333333ULL) | ((val & 0x3333333333333333ULL) << 2);
+    val = ((val >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((val & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(val);
+}
+
+// Moves the pattern to the top left corner and shrinks it to its bounding box.
+void
+crop_pattern(pattern* pat)
+{
+    uint64_t cols = 0;
+    size_t first_row = PATTERN_MAX_SIZE;
+    size_t last_row = 0;
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+    {
+        if (pat->rows[i])
+        {
+            first_row = (first_row == PATTERN_MAX_SIZE) ? i : first_row;
+            last_row = i;
+            cols |= pat->rows[i];
+        }
+    }
+
+    if (!cols)
+    {
+        memset(pat, 0, sizeof(pattern));
+        return;
+    }
+
+    const size_t first_col = __builtin_ctzll(cols);
+    const size_t height = last_row - first_row + 1;
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+        pat->rows[i] = (i < height) ? pat->rows[i + first_row] >> first_col : 0;
+
+    pat->height = height;
+    pat->width = 64 - __builtin_clzll(cols) - first_col;
+}
+
+// Rows of 'o' (alive) and '.' (dead), terminated by NULL.
+void
+pattern_from_strings(pattern* pat,
+                     const char* const* rows)
+{
+    memset(pat, 0, sizeof(pattern));
+    for (size_t i = 0; rows[i] && i != PATTERN_MAX_SIZE; ++i)
+        for (size_t j = 0; rows[i][j] && j != PATTERN_MAX_SIZE; ++j)
+            pat->rows[i] |= (uint64_t)(rows[i][j] == 'o') << j;
+
+    crop_pattern(pat);
+}
+
+// Pattern of the components marked in 'members', whose bounding box is 'box'.
+// Returns false if they do not fit in a pattern.
+bool
+pattern_from_components(pattern* pat,
+                        const component_labels* labels,
+                        const bool* members,
+                        const component* box)
+{
+    if (box->row_end - box->row_begin > PATTERN_MAX_SIZE ||
+        box->col_end - box->col_begin > PATTERN_MAX_SIZE)
+    {
+        return false;
+    }
+
+    memset(pat, 0, sizeof(pattern));
+    pat->height = box->row_end - box->row_begin;
+    pat->width = box->col_end - box->col_begin;
+
+    const size_t col_begin = box->col_begin + CELL_COL_OFFSET;
+    for (size_t r = 0; r != labels->run_count; ++r)
+    {
+        const cell_run* run = &labels->runs[r];
+        if (!members[run->label])
+            continue;
+
+        const size_t length = run->end - run->begin;
+        const uint64_t bits = (length == 64) ? ~0ULL : ((1ULL << length) - 1);
+        pat->rows[run->row - box->row_begin] |= bits << (run->begin - col_begin);
+    }
+
+    return true;
+}
+
+// Advances the pattern one generation, the result is cropped again.
+// The pattern must leave room for one cell of growth on every side.
+void
+step_pattern(pattern* pat)
+{
+    uint64_t rows[PATTERN_MAX_SIZE + 2] = {0};
+    for (size_t i = 0; i != pat->height; ++i)
+        rows[i + 2] = pat->rows[i] << 1;
+
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+    {
+        const uint64_t above = rows[i];
+        const uint64_t curr = rows[i + 1];
+        const uint64_t below = rows[i + 2];
+        const uint64_t neighbors[8] =
+        {
+            above << 1, above, above >> 1,
+            curr << 1, curr >> 1,
+            below << 1, below, below >> 1,
+        };
+        pat->rows[i] = life_rule_word(neighbors, curr);
+    }
+
+    crop_pattern(pat);
+}
+
+// Transposes a 64 x 64 bit matrix in place, bit j of rows[i] moves to
+// bit i of rows[j]. Each round swaps the two off diagonal blocks of
+// every block on the diagonal, 32 x 32 blocks first and single bits
+// last. A round is the same masked shift over pairs of rows, which the
+// compiler turns into vector operations.
+void
+transpose_bits_64(uint64_t rows[64])
+{
+    const uint64_t masks[6] =
+    {
+        0x00000000FFFFFFFFULL,
+        0x0000FFFF0000FFFFULL,
+        0x00FF00FF00FF00FFULL,
+        0x0F0F0F0F0F0F0F0FULL,
+        0x3333333333333333ULL,
+        0x5555555555555555ULL,
+    };
+
+    for (size_t round = 0; round != 6; ++round)
+    {
+        const size_t size = 32 >> round;
+        const uint64_t mask = masks[round];
+        for (size_t block = 0; block != 64; block += 2 * size)
+        {
+            for (size_t i = block; i != block + size; ++i)
+            {
+                const uint64_t swap = ((rows[i] >> size) ^ rows[i + size]) & mask;
+                rows[i] ^= swap << size;
+                rows[i + size] ^= swap;
+            }
+        }
+    }
+}
+
+void
+flip_bits_rows_64(uint64_t rows[64])
+{
+    for (size_t i = 0; i != 32; ++i)
+    {
+        const uint64_t tmp = rows[i];
+        rows[i] = rows[63 - i];
+        rows[63 - i] = tmp;
+    }
+}
+
+void
+flip_bits_cols_64(uint64_t rows[64])
+{
+    for (size_t i = 0; i != 64; ++i)
+        rows[i] = reverse_bits(rows[i]);
+}
+
+// Turns a 64 x 64 bit matrix clockwise, row 0 on top and bit 0 as the
+// leftmost column.
+void
+rotate_bits_64(uint64_t rows[64],
+               const size_t quarter_turns)
+{
+    switch (quarter_turns % 4)
+    {
+    case 1:
+        transpose_bits_64(rows);
+        flip_bits_cols_64(rows);
+        break;
+    case 2:
+        flip_bits_rows_64(rows);
+        flip_bits_cols_64(rows);
+        break;
+    case 3:
+        transpose_bits_64(rows);
+        flip_bits_rows_64(rows);
+        break;
+    default:
+        break;
+    }
+}
+
+// Patterns sit in the top left corner of their 64 x 64 tile. Flipping
+// or turning the tile leaves them against the bottom or the right
+// edge, this moves them back.
+void
+align_pattern(pattern* pat,
+              const bool bottom,
+              const bool right)
+{
+    if (bottom)
+    {
+        memmove(pat->rows, &pat->rows[PATTERN_MAX_SIZE - pat->height], pat->height * sizeof(uint64_t));
+        memset(&pat->rows[pat->height], 0, (PATTERN_MAX_SIZE - pat->height) * sizeof(uint64_t));
+    }
+
+    if (right)
+        for (size_t i = 0; i != pat->height; ++i)
+            pat->rows[i] >>= PATTERN_MAX_SIZE - pat->width;
+}
+
+void
+flip_rows(pattern* pat)
+{
+    flip_bits_rows_64(pat->rows);
+    align_pattern(pat, true, false);
+}
+
+void
+flip_cols(pattern* pat)
+{
+    flip_bits_cols_64(pat->rows);
+    align_pattern(pat, false, true);
+}
+
+// Turns the pattern clockwise.
+void
+rotate_pattern(pattern* pat,
+               const size_t quarter_turns)
+{
+    const size_t turns = quarter_turns % 4;
+    rotate_bits_64(pat->rows, turns);
+    if (turns % 2 != 0)
+    {
+        const size_t width = pat->width;
+        pat->width = pat->height;
+        pat->height = width;
+    }
+    align_pattern(pat, turns >= 2, turns == 1 || turns == 2);
+}
+
+uint64_t
+hash_pattern(const pattern* pat)
+{
+    uint64_t hash = hash_combine(pat->width, pat->height);
+    for (size_t i = 0; i != pat->height; ++i)
+        hash = hash_combine(hash, pat->rows[i]);
+    return hash;
+}
+
+bool
+equal_patterns(const pattern* a,
+               const pattern* b)
+{
+    return a->width == b->width &&
+           a->height == b->height &&
+           memcmp(a->rows, b->rows, a->height * sizeof(uint64_t)) == 0;
+}
+
+// Replaces the pattern by the one of its 8 symmetries with the
+// smallest hash, and returns that hash. Patterns that are the same
+// up to symmetry end up equal.
+uint64_t
+canonical_pattern(pattern* pat)
+{
+    pattern sym = (*pat);
+    uint64_t best = UINT64_MAX;
+
+    // Every symmetry is one of the 4 flips, with or without a quarter
+    // turn. Column flips and clockwise turns reverse all 64 rows of the
+    // tile, row flips and counterclockwise turns only move rows, so the
+    // former are rarer.
+    for (size_t t = 0; t != 2; ++t)
+    {
+        for (size_t f = 0; f != 4; ++f)
+        {
+            const uint64_t hash = hash_pattern(&sym);
+            if (hash < best)
+            {
+                best = hash;
+                (*pat) = sym;
+            }
+
+            if (f % 2 == 0)
+                flip_rows(&sym);
+            else if (f == 1)
+                flip_cols(&sym);
+        }
+        if (t == 0)
+            rotate_pattern(&sym, 3);
+    }
+
+    return best;
+}
+
+typedef enum
+{
+    OBJECT_STILL_LIFE,
+    OBJECT_OSCILLATOR,
+    OBJECT_SPACESHIP,
+} object_kind;
+
+typedef struct
+{
+    const char* name;
+    object_kind kind;
+    size_t period;
+    const char* const* rows;
+} known_object;
+
+const known_object known_objects[] =
+{
+    { "block", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo", "oo", NULL } },
+    { "beehive", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".oo.", "o..o", ".oo.", NULL } },
+    { "loaf", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".oo.", "o..o", ".o.o", "..o.", NULL } },
+    { "boat", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo.", "o.o", ".o.", NULL } },
+    { "ship", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo.", "o.o", ".oo", NULL } },
+    { "tub", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".o.", "o.o", ".o.", NULL } },
+    { "pond", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".oo.", "o..o", "o..o", ".oo.", NULL } },
+    { "long boat", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".o..", "o.o.", ".o.o", "..oo", NULL } },
+    { "barge", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".o..", "o.o.", ".o.o", "..o.", NULL } },
+    { "mango", OBJECT_STILL_LIFE, 1, (const char* const[]){ ".oo..", "o..o.", ".o..o", "..oo.", NULL } },
+    { "eater 1", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo..", "o.o.", "..o.", "..oo", NULL } },
+    { "snake", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo.o", "o.oo", NULL } },
+    { "aircraft carrier", OBJECT_STILL_LIFE, 1, (const char* const[]){ "oo..", "o..o", "..oo", NULL } },
+    { "blinker", OBJECT_OSCILLATOR, 2, (const char* const[]){ "ooo", NULL } },
+    { "toad", OBJECT_OSCILLATOR, 2, (const char* const[]){ ".ooo", "ooo.", NULL } },
+    { "beacon", OBJECT_OSCILLATOR, 2, (const char* const[]){ "oo..", "oo..", "..oo", "..oo", NULL } },
+    { "clock", OBJECT_OSCILLATOR, 2, (const char* const[]){ "..o.", "o.o.", ".o.o", ".o..", NULL } },
+    { "pulsar", OBJECT_OSCILLATOR, 3, (const char* const[])
+        {
+            "..ooo...ooo..",
+            ".............",
+            "o....o.o....o",
+            "o....o.o....o",
+            "o....o.o....o",
+            "..ooo...ooo..",
+            ".............",
+            "..ooo...ooo..",
+            "o....o.o....o",
+            "o....o.o....o",
+            "o....o.o....o",
+            ".............",
+            "..ooo...ooo..",
+            NULL,
+        }
+    },
+    { "pentadecathlon", OBJECT_OSCILLATOR, 15, (const char* const[]){ "..o....o..", "oo.oooo.oo", "..o....o..", NULL } },
+    { "glider", OBJECT_SPACESHIP, 4, (const char* const[]){ ".o.", "..o", "ooo", NULL } },
+    { "lightweight spaceship", OBJECT_SPACESHIP, 4, (const char* const[]){ ".o..o", "o....", "o...o", "oooo.", NULL } },
+    { "middleweight spaceship", OBJECT_SPACESHIP, 4, (const char* const[]){ "...o..", ".o...o", "o.....", "o....o", "ooooo.", NULL } },
+    { "heavyweight spaceship", OBJECT_SPACESHIP, 4, (const char* const[]){ "...oo..", ".o....o", "o......", "o.....o", "oooooo.", NULL } },
+};
+
+#define KNOWN_OBJECT_COUNT (sizeof(known_objects) / sizeof(known_objects[0]))
+
+// Open addressing table from canonical hash to known object,
+// sized to stay at most a quarter full.
+// Entries keep their canonical pattern, so different patterns
+// that share a hash get their own entries.
+#define OBJECT_TABLE_SIZE 256
+
+typedef struct
+{
+    uint64_t hashes[OBJECT_TABLE_SIZE];
+    pattern patterns[OBJECT_TABLE_SIZE];
+    const known_object* objects[OBJECT_TABLE_SIZE];
+} object_dictionary;
+
+void
+insert_object(object_dictionary* dict,
+              const pattern* pat,
+              const known_object* obj)
+{
+    pattern canon = (*pat);
+    const uint64_t hash = canonical_pattern(&canon);
+
+    size_t idx = hash & (OBJECT_TABLE_SIZE - 1);
+    while (dict->objects[idx])
+    {
+        if (dict->hashes[idx] == hash && equal_patterns(&dict->patterns[idx], &canon))
+        {
+            // Phases repeat within an object, but never across objects.
+            if (dict->objects[idx] != obj)
+            {
+                fprintf(stderr, "object dictionary: %s and %s share a phase\n",
+                        dict->objects[idx]->name, obj->name);
+            }
+            return;
+        }
+        idx = (idx + 1) & (OBJECT_TABLE_SIZE - 1);
+    }
+
+    dict->hashes[idx] = hash;
+    dict->patterns[idx] = canon;
+    dict->objects[idx] = obj;
+}
+
+// Every phase of every known object is added,
+// found by running the object for one period.
+object_dictionary*
+create_object_dictionary()
+{
+    object_dictionary* dict = calloc(1, sizeof(object_dictionary));
+    for (size_t i = 0; i != KNOWN_OBJECT_COUNT; ++i)
+    {
+        pattern pat;
+        pattern_from_strings(&pat, known_objects[i].rows);
+        for (size_t p = 0; p != known_objects[i].period; ++p)
+        {
+            insert_object(dict, &pat, &known_objects[i]);
+            step_pattern(&pat);
+        }
+    }
+    return dict;
+}
+
+const known_object*
+identify_pattern(const object_dictionary* dict,
+                 const pattern* pat)
+{
+    pattern canon = (*pat);
+    const uint64_t hash = canonical_pattern(&canon);
+
+    size_t idx = hash & (OBJECT_TABLE_SIZE - 1);
+    while (dict->objects[idx])
+    {
+        if (dict->hashes[idx] == hash && equal_patterns(&dict->patterns[idx], &canon))
+            return dict->objects[idx];
+        idx = (idx + 1) & (OBJECT_TABLE_SIZE - 1);
+    }
+    return NULL;
+}
+
+bool
+are_components_near(const component* a,
+                    const component* b)
+{
+    return a->row_begin <= b->row_end + OBJECT_GAP &&
+           b->row_begin <= a->row_end + OBJECT_GAP &&
+           a->col_begin <= b->col_end + OBJECT_GAP &&
+           b->col_begin <= a->col_end + OBJECT_GAP;
+}
+
+// Marks the components near 'index', directly or through other
+// marked components, and grows 'box' to cover them.
+// Returns the number of marked components.
+size_t
+group_component(const component_labels* labels,
+                const size_t index,
+                bool* members,
+                component* box)
+{
+    (*box) = labels->components[index];
+    members[index] = true;
+    size_t count = 1;
+
+    bool grown = true;
+    while (grown)
+    {
+        grown = false;
+        for (size_t i = 0; i != labels->component_count; ++i)
+        {
+            const component* comp = &labels->components[i];
+
+            // Components are sorted by their first row
+            if (comp->row_begin > box->row_end + OBJECT_GAP)
+                break;
+
+            if (members[i] || !are_components_near(box, comp))
+                continue;
+
+            members[i] = true;
+            count++;
+            grown = true;
+            box->row_begin = (comp->row_begin < box->row_begin) ? comp->row_begin : box->row_begin;
+            box->row_end = (comp->row_end > box->row_end) ? comp->row_end : box->row_end;
+            box->col_begin = (comp->col_begin < box->col_begin) ? comp->col_begin : box->col_begin;
+            box->col_end = (comp->col_end > box->col_end) ? comp->col_end : box->col_end;
+        }
+    }
+
+    return count;
+}
+
+// Some objects fall apart into pieces in some of their phases,
+// so the component is first identified together with the pieces
+// near it. If they make up no known object, which is also the case
+// for separate objects that happen to be close, the component is
+// identified on its own.
+const known_object*
+identify_component(const object_dictionary* dict,
+                   const component_labels* labels,
+                   const size_t index)
+{
+    bool* members = calloc(labels->component_count, sizeof(bool));
+    const known_object* obj = NULL;
+    pattern pat;
+    component box;
+
+    if (group_component(labels, index, members, &box) > 1 &&
+        pattern_from_components(&pat, labels, members, &box))
+    {
+        obj = identify_pattern(dict, &pat);
+    }
+
+    if (!obj)
+    {
+        memset(members, 0, labels->component_count * sizeof(bool));
+        members[index] = true;
+        if (pattern_from_components(&pat, labels, members, &labels->components[index]))
+            obj = identify_pattern(dict, &pat);
+    }
+
+    free(members);
+    return obj;
+}
+
+void
+print_components(const component_labels* labels,
+                 const object_dictionary* dict,
+                 const size_t max_count)
+{
+    printf("components: %zu\n", labels->component_count);
+    for (size_t i = 0; i != labels->component_count && i != max_count; ++i)
+    {
+        const component* comp = &labels->components[i];
+        const known_object* obj = identify_component(dict, labels, i);
+        printf("  [%zu] rows: %zu-%zu, cols: %zu-%zu, population: %zu%s%s\n",
+               i,
+               comp->row_begin, comp->row_end - 1,
+               comp->col_begin, comp->col_end - 1,
+               comp->population,
+               obj ? ", " : "",
+               obj ? obj->name : "");
+    }
+}
+
+///////////////////////////////////////////////////////////
+/// Word kernels
+///////////////////////////////////////////////////////////
+// Rows loaded into 64 bit words, bit n of word w is outer column
+// w * 64 + n, so the rule runs on 64 cells at a time.
+
+// Only the inner columns may come alive, the border stays dead.
+void
+init_row_mask(uint64_t* mask,
+              const size_t cols)
+{
+    for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+    {
+        mask[w] = 0;
+        for (size_t b = 0; b != 64; ++b)
+        {
+            const size_t col = w * 64 + b;
+            if (col >= CELL_COL_OFFSET && col < cols + CELL_COL_OFFSET)
+                mask[w] |= 1ULL << b;
+        }
+    }
+}
+
+void
+load_row_words(uint64_t* restrict words,
+               const cell* restrict row,
+               const size_t row_bytes)
+{
+    for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+        words[w] = load_row_word(row, w, row_bytes);
+}
+
+void
+store_row_words(cell* restrict row,
+                const uint64_t* restrict words,
+                const size_t row_bytes)
+{
+    for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+    {
+        const size_t offset = w * 8;
+        const size_t size = (row_bytes - offset < 8) ? row_bytes - offset : 8;
+        memcpy(row + offset, &words[w], size);
+    }
+}
+
+// Next generation of the row 'curr'.
+void
+life_row_words(uint64_t* restrict out,
+               const uint64_t* restrict above,
+               const uint64_t* restrict curr,
+               const uint64_t* restrict below,
+               const uint64_t* restrict mask)
+{
+    for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+    {
+        // Bit n of west holds column n - 1, bit n of east column n + 1
+        const bool first = w == 0;
+        const bool last = w + 1 == ROW_WORD_COUNT;
+        const uint64_t neighbors[8] =
+        {
+            (above[w] << 1) | (first ? 0 : above[w - 1] >> 63),
+            above[w],
+            (above[w] >> 1) | (last ? 0 : above[w + 1] << 63),
+            (curr[w] << 1) | (first ? 0 : curr[w - 1] >> 63),
+            (curr[w] >> 1) | (last ? 0 : curr[w + 1] << 63),
+            (below[w] << 1) | (first ? 0 : below[w - 1] >> 63),
+            below[w],
+            (below[w] >> 1) | (last ? 0 : below[w + 1] << 63),
+        };
+        out[w] = life_rule_word(neighbors, curr[w]) & mask[w];
+    }
+}
+
+// Generation g of a band row. Rows next to the band come from 'edge',
+// which holds rows row_begin - 2, row_begin - 1, row_end, row_end + 1,
+// copied before any band started writing.
+void
+load_band_row(uint64_t* restrict words,
+              const cell* restrict grid,
+              const cell* restrict edge,
+              const int64_t row,
+              const size_t row_begin,
+              const size_t row_end,
+              const size_t row_bytes)
+{
+    const cell* src;
+    if (row < (int64_t)row_begin)
+        src = &edge[(row - ((int64_t)row_begin - 2)) * row_bytes];
+    else if (row >= (int64_t)row_end)
+        src = &edge[(2 + row - (int64_t)row_end) * row_bytes];
+    else
+        src = &grid[get_byte_idx(row, -1)];
+    load_row_words(words, src, row_bytes);
+}
+
+// Advances rows [row_begin, row_end) two generations in one pass.
+// Generation g + 1 of rows i - 1, i, i + 1 is computed from rows
+// i - 2 to i + 2 of generation g, and kept in a rolling window of
+// three rows, from which row i of generation g + 2 follows.
+// Each row of the grid is read and written once for two generations,
+// and the bands only synchronize once.
+// Generation g + 1 of the border rows is forced dead, as the
+// single step kernel never updates them.
+void
+sub_update_two(cell* restrict grid,
+               const cell* restrict edge,
+               uint32_t* restrict tile_pop,
+               const size_t row_begin,
+               const size_t row_end,
+               const size_t rows,
+               const size_t cols)
+{
+    const size_t row_bytes = (cols + CELL_COL_OFFSET * 2) / 8;
+    uint64_t mask[ROW_WORD_COUNT];
+    init_row_mask(mask, cols);
+
+    // Generation g rows i - 2 to i + 2, and generation g + 1 rows i - 1 to i + 1
+    uint64_t old_rows[5][ROW_WORD_COUNT];
+    uint64_t mid_rows[3][ROW_WORD_COUNT];
+    uint64_t* old[5] = { old_rows[0], old_rows[1], old_rows[2], old_rows[3], old_rows[4] };
+    uint64_t* mid[3] = { mid_rows[0], mid_rows[1], mid_rows[2] };
+
+    const int64_t begin = (int64_t)row_begin;
+    for (int64_t r = 0; r != 4; ++r)
+        load_band_row(old[r], grid, edge, begin - 2 + r, row_begin, row_end, row_bytes);
+
+    if (row_begin == 0)
+        memset(mid[0], 0, sizeof(mid_rows[0]));
+    else
+        life_row_words(mid[0], old[0], old[1], old[2], mask);
+    life_row_words(mid[1], old[1], old[2], old[3], mask);
+
+    memset(&tile_pop[(row_begin / TILE_SIZE) * TILE_COL_COUNT], 0,
+           ((row_end - row_begin) / TILE_SIZE) * TILE_COL_COUNT * sizeof(uint32_t));
+
+    for (size_t i = row_begin; i != row_end; ++i)
+    {
+        load_band_row(old[4], grid, edge, (int64_t)i + 2, row_begin, row_end, row_bytes);
+
+        if (i + 1 == rows)
+            memset(mid[2], 0, sizeof(mid_rows[0]));
+        else
+            life_row_words(mid[2], old[2], old[3], old[4], mask);
+
+        uint64_t next[ROW_WORD_COUNT];
+        life_row_words(next, mid[0], mid[1], mid[2], mask);
+
+        // Generation g of row i is only needed from the window now
+        store_row_words(&grid[get_byte_idx(i, -1)], next, row_bytes);
+        add_row_to_tiles(tile_pop, grid, i);
+
+        uint64_t* old_first = old[0];
+        for (size_t r = 0; r != 4; ++r)
+            old[r] = old[r + 1];
+        old[4] = old_first;
+
+        uint64_t* mid_first = mid[0];
+        mid[0] = mid[1];
+        mid[1] = mid[2];
+        mid[2] = mid_first;
+    }
+}
+
+// Next state of word w of the row between rows a and b.
+uint64_t
+life_word_at(const uint64_t* restrict a,
+             const uint64_t* restrict c,
+             const uint64_t* restrict b,
+             const size_t w)
+{
+    // Bit n of west holds column n - 1, bit n of east column n + 1
+    const uint64_t a_west = (a[w] << 1) | (w != 0 ? a[w - 1] >> 63 : 0);
+    const uint64_t c_west = (c[w] << 1) | (w != 0 ? c[w - 1] >> 63 : 0);
+    const uint64_t b_west = (b[w] << 1) | (w != 0 ? b[w - 1] >> 63 : 0);
+    const uint64_t a_east = (a[w] >> 1) | (w + 1 != ROW_WORD_COUNT ? a[w + 1] << 63 : 0);
+    const uint64_t c_east = (c[w] >> 1) | (w + 1 != ROW_WORD_COUNT ? c[w + 1] << 63 : 0);
+    const uint64_t b_east = (b[w] >> 1) | (w + 1 != ROW_WORD_COUNT ? b[w + 1] << 63 : 0);
+
+    const uint64_t neighbors[8] =
+    {
+        a_west, a[w], a_east,
+        c_west, c_east,
+        b_west, b[w], b_east,
+    };
+    return life_rule_word(neighbors, c[w]);
+}
+
+// Damage spreading: rows [row_begin, row_end) of the grid and of its
+// twin are stepped one generation in one fused pass, and the number
+// of cells where they differ afterwards is returned.
+// Each row of both grids is loaded once into word buffers, and the
+// distance comes from popcounting the XOR of the results before they
+// are stored. The twin only differs around the damage: where the words
+// around word w are the same in both grids, so is the next word w, and
+// the twin's is not computed again.
+// 'edge' holds the edge rows of the grid (see load_band_row),
+// followed by the edge rows of the twin.
+// Without a twin only the grid is stepped, the same pass on one grid.
+size_t
+sub_update_damage(cell* restrict grid,
+                  cell* restrict twin,
+                  const cell* restrict edge,
+                  uint32_t* restrict tile_pop,
+                  const size_t row_begin,
+                  const size_t row_end,
+                  const size_t cols)
+{
+    const size_t row_bytes = (cols + CELL_COL_OFFSET * 2) / 8;
+    const size_t grid_count = (twin != NULL) ? 2 : 1;
+    cell* grids[2] = { grid, twin };
+    const cell* edges[2] = { edge, edge + 4 * row_bytes };
+
+    uint64_t mask[ROW_WORD_COUNT];
+    init_row_mask(mask, cols);
+
+    // Rolling window of original rows: above, current, below
+    uint64_t window[2][3][ROW_WORD_COUNT];
+    for (size_t g = 0; g != grid_count; ++g)
+    {
+        load_band_row(window[g][0], grids[g], edges[g], (int64_t)row_begin - 1,
+                      row_begin, row_end, row_bytes);
+        load_band_row(window[g][1], grids[g], edges[g], (int64_t)row_begin,
+                      row_begin, row_end, row_bytes);
+    }
+
+    memset(&tile_pop[(row_begin / TILE_SIZE) * TILE_COL_COUNT], 0,
+           ((row_end - row_begin) / TILE_SIZE) * TILE_COL_COUNT * sizeof(uint32_t));
+
+    size_t distance = 0;
+    size_t above = 0;
+    size_t curr = 1;
+    size_t below = 2;
+    for (size_t i = row_begin; i != row_end; ++i)
+    {
+        for (size_t g = 0; g != grid_count; ++g)
+        {
+            load_band_row(window[g][below], grids[g], edges[g], (int64_t)i + 1,
+                          row_begin, row_end, row_bytes);
+        }
+
+        uint64_t next[2][ROW_WORD_COUNT];
+        life_row_words(next[0], window[0][above], window[0][curr], window[0][below], mask);
+
+        if (twin != NULL)
+        {
+            // Words of the three rows where the grids differ
+            uint64_t differ[ROW_WORD_COUNT];
+            for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+            {
+                differ[w] = (window[0][above][w] ^ window[1][above][w]) |
+                            (window[0][curr][w] ^ window[1][curr][w]) |
+                            (window[0][below][w] ^ window[1][below][w]);
+            }
+
+            for (size_t w = 0; w != ROW_WORD_COUNT; ++w)
+            {
+                const uint64_t near = differ[w] |
+                                      (w != 0 ? differ[w - 1] >> 63 : 0) |
+                                      (w + 1 != ROW_WORD_COUNT ? differ[w + 1] << 63 : 0);
+                if (near == 0)
+                {
+                    next[1][w] = next[0][w];
+                    continue;
+                }
+
+                next[1][w] = life_word_at(window[1][above], window[1][curr], window[1][below], w) & mask[w];
+                distance += __builtin_popcountll(next[0][w] ^ next[1][w]);
+            }
+        }
+
+        // The originals of this row are in the window, so it can be overwritten
+        for (size_t g = 0; g != grid_count; ++g)
+            store_row_words(&grids[g][get_byte_idx(i, -1)], next[g], row_bytes);
+        add_row_to_tiles(tile_pop, grid, i);
+
+        const size_t tmp = above;
+        above = curr;
+        curr = below;
+        below = tmp;
+    }
+
+    return distance;
+}
+
+///////////////////////////////////////////////////////////
+/// SDL
+///////////////////////////////////////////////////////////
+int
+sdl_init(SDL_Window** out_window,
+         SDL_Renderer** out_renderer,
+         const int window_width,
+         const int window_height)
+{
+    (*out_window) = NULL;
+    (*out_renderer) = NULL;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        goto failure;
+    }
+
+    (*out_window) = SDL_CreateWindow("non_double_buffered_conways",
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     SDL_WINDOWPOS_UNDEFINED,
+                                     window_width,
+                                     window_height,
+                                     SDL_WINDOW_SHOWN);
+
+    if ((*out_window) == NULL)
+    {
+        goto failure;
+    }
+
+    (*out_renderer) = SDL_CreateRenderer((*out_window),
+                                         -1,
+                                         SDL_RENDERER_ACCELERATED);
+
+    if ((*out_renderer) == NULL)
+    {
+        goto failure;
+    }
+
+    return 1;
+
+failure:
+    fprintf(stderr, "SDL_Error: %s\n", SDL_GetError());
+    SDL_DestroyRenderer((*out_renderer));
+    SDL_DestroyWindow((*out_window));
+    return 0;
+}
+
+void
+sdl_shutdown(SDL_Window* window,
+             SDL_Renderer* renderer)
+{
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+bool
+handle_events(cell* grid,
+              tile_summary* tiles,
+              const object_dictionary* dict,
+              const size_t rows,
+              const size_t cols,
+              bool* iterate,
+              bool* toggle_recording,
+              bool* take_snapshot,
+              bool* toggle_tracking,
+              bool* toggle_damage,
+              size_t* generations)
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        if (event.type == SDL_QUIT ||
+            (event.type == SDL_KEYUP &&
+             event.key.keysym.sym == SDLK_ESCAPE))
+        {
+            return false;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_SPACE)
+        {
+            (*iterate) = !(*iterate);
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_r)
+        {
+            (*toggle_recording) = true;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_s)
+        {
+            (*take_snapshot) = true;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_t)
+        {
+            (*toggle_tracking) = true;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_d)
+        {
+            (*toggle_damage) = true;
+        }
+
+        // Two generations per update, in a single pass
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_g)
+        {
+            (*generations) = ((*generations) == 1) ? 2 : 1;
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_p)
+        {
+            print_population(grid, tiles, rows, cols);
+        }
+
+        if (event.type == SDL_KEYUP &&
+            event.key.keysym.sym == SDLK_c)
+        {
+            component_labels labels = label_components(grid, rows, cols, THREAD_COUNT);
+            print_components(&labels, dict, 32);
+            destroy_component_labels(&labels);
+        }
+
+        if (event.type == SDL_MOUSEBUTTONUP)
+        {
+            const int64_t selected_col = event.button.x / CELL_WIDTH;
+            const int64_t selected_row = event.button.y / CELL_HEIGHT;
+
+            if (selected_col >= 0 && selected_col < (int64_t)cols &&
+                selected_row >= 0 && selected_row < (int64_t)rows)
+            {
+                bool val = get_cell(grid, selected_row, selected_col);
+                set_cell_tracked(grid, tiles, selected_row, selected_col, !val);
+            }
+        }
+    }
+    return true;
+}
+
+void
+draw_grid(cell* grid,
+          const size_t rows,
+          const size_t cols,
+          SDL_Renderer* renderer)
+{
+    SDL_Color prev_color;
+    SDL_GetRenderDrawColor(renderer,
+                           &prev_color.r,
+                           &prev_color.g,
+                           &prev_color.b,
+                           &prev_color.a);
+
+    SDL_SetRenderDrawColor(renderer, 0, 128, 255, 255);
+
+    bool cells[CELL_COL_COUNT];
+    for (size_t i = 0; i != rows; ++i)
+    {
+        unpack_row(cells, &grid[get_byte_idx(i, -1)], cols);
+        for (size_t j = 0; j != cols; ++j)
+        {
+            if (cells[j])
+            {
+                SDL_Rect rect =
+                {
+                    .x = j * CELL_WIDTH + BORDER_WIDTH,
+                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
+                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
+                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
+                };
+
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer,
+                           prev_color.r,
+                           prev_color.g,
+                           prev_color.b,
+                           prev_color.a);
+}
+
+///////////////////////////////////////////////////////////
+/// Threads
+///////////////////////////////////////////////////////////
+// Contains all information needed by a single thread to run.
+typedef struct
+{
+    cell* restrict grid;
+    size_t row_begin;
+    size_t row_end;
+    size_t rows;
+    size_t cols;
+
+    cell* restrict above_buffer;
+    cell* restrict current_buffer;
+    cell* restrict border_buffer;
+    uint32_t* tile_pop;
+
+    // Generations per update, 1 or 2.
+    // For 2 the edge buffer holds the two rows on each side of the band.
+    size_t generations;
+    cell* restrict edge_buffer;
+
+    // Damage twin, stepped along with the grid when set.
+    // The edge buffer then holds the edge rows of both,
+    // and the distance of the band is left in 'distance'.
+    cell* restrict twin;
+    size_t distance;
+
+    // One generation through the damage pass without a twin,
+    // the edge buffer then holds the edge rows of the grid.
+    bool damage_pass;
+
+    // Synchronization vars
+    // 'round' counts the updates started, guarded by cv_mtx,
+    // so a wake up is not lost if a thread is not waiting yet.
+    atomic_bool* running;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    size_t* round;
+
+    size_t id;
+} thread_params;
+
+void
+update_band(thread_params* args)
+{
+    if (args->twin || args->damage_pass)
+    {
+        args->distance = sub_update_damage(args->grid, args->twin, args->edge_buffer,
+                                           args->tile_pop, args->row_begin,
+                                           args->row_end, args->cols);
+    }
+    else if (args->generations == 2)
+    {
+        sub_update_two(args->grid, args->edge_buffer, args->tile_pop,
+                       args->row_begin, args->row_end, args->rows, args->cols);
+    }
+    else
+    {
+        sub_update(args->grid, args->above_buffer,
+                   args->current_buffer, args->border_buffer,
+                   args->tile_pop, args->row_begin, args->row_end,
+                   args->cols, args->id);
+    }
+}
+
+void*
+thread_execution(void* params)
+{
+    thread_params* args = (thread_params*)params;
+    size_t seen = 0;
+    while (true)
+    {
+        pthread_mutex_lock(args->cv_mtx);
+        while ((*args->round) == seen &&
+               atomic_load_explicit(args->running, memory_order_relaxed))
+        {
+            pthread_cond_wait(args->cv, args->cv_mtx);
+        }
+        seen = (*args->round);
+        pthread_mutex_unlock(args->cv_mtx);
+
+        if (!atomic_load_explicit(args->running, memory_order_relaxed))
+            break;
+
+        update_band(args);
+
+        atomic_fetch_add_explicit(args->signal, 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Holds all variables that needs to be deallocated,
+// and that is used to communicate between threads.
+// This structure should be merged together with thread_params.
+typedef struct
+{
+    atomic_bool* running;
+    atomic_int* signal;
+    pthread_cond_t* cv;
+    pthread_mutex_t* cv_mtx;
+    size_t* round;
+    pthread_t* threads;
+    thread_params* params;
+    tile_summary* tiles;
+} thread_info;
+
+thread_info
+create_threads(cell* restrict grid,
+               tile_summary* tiles,
                const size_t rows,
                const size_t cols)
 {
-    thread_info info =
+    thread_info info =
+    {
+        .running = malloc(sizeof(atomic_bool)),
+        .signal = malloc(sizeof(atomic_int)),
+        .cv = malloc(sizeof(pthread_cond_t)),
+        .cv_mtx = malloc(sizeof(pthread_mutex_t)),
+        .round = calloc(1, sizeof(size_t)),
+        .threads = malloc((THREAD_COUNT - 1) * sizeof(pthread_t)),
+        .params = malloc((THREAD_COUNT) * sizeof(thread_params)),
+        .tiles = tiles,
+    };
+
+    atomic_init(info.running, true);
+    atomic_init(info.signal, 0);
+    pthread_cond_init(info.cv, NULL);
+    pthread_mutex_init(info.cv_mtx, NULL);
+
+    // Initialize threads and start execution
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        info.params[i].grid = grid;
+        info.params[i].row_begin = (rows / THREAD_COUNT) * i;
+        info.params[i].row_end = (rows / THREAD_COUNT) * (i + 1);
+        info.params[i].rows = rows;
+        info.params[i].cols = cols;
+        info.params[i].tile_pop = tiles->pop;
+        info.params[i].generations = 1;
+        info.params[i].twin = NULL;
+        info.params[i].damage_pass = false;
+        info.params[i].distance = 0;
+        info.params[i].running = info.running;
+        info.params[i].signal = info.signal;
+        info.params[i].cv = info.cv;
+        info.params[i].cv_mtx = info.cv_mtx;
+        info.params[i].round = info.round;
+        info.params[i].id = i;
+
+        info.params[i].above_buffer = create_row(CELL_COL_COUNT);
+        info.params[i].current_buffer = create_row(CELL_COL_COUNT);
+        info.params[i].border_buffer = create_row(CELL_COL_COUNT);
+        info.params[i].edge_buffer = calloc(8, (CELL_TOT_COL / 8) * sizeof(cell));
+    }
+
+
+    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
+        pthread_create(&info.threads[i], NULL, thread_execution, &info.params[i + 1]);
+
+    return info;
+}
+
+void
+destroy_threads(thread_info* info)
+{
+    pthread_mutex_lock(info->cv_mtx);
+    atomic_store_explicit(info->running, false, memory_order_release);
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
+        pthread_join(info->threads[i], NULL);
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        free(info->params[i].above_buffer);
+        free(info->params[i].current_buffer);
+        free(info->params[i].border_buffer);
+        free(info->params[i].edge_buffer);
+    }
+
+    pthread_cond_destroy(info->cv);
+    pthread_mutex_destroy(info->cv_mtx);
+    free(info->running);
+    free(info->signal);
+    free(info->cv);
+    free(info->cv_mtx);
+    free(info->round);
+    free(info->threads);
+    free(info->params);
+}
+
+// Copies rows row_begin - 2, row_begin - 1, row_end and row_end + 1
+// of 'grid' into 'edge', in the layout load_band_row expects.
+void
+copy_band_edges(cell* restrict edge,
+                const cell* restrict grid,
+                const thread_params* params)
+{
+    // Rows outside the allocated grid (beyond the border rows) are dead
+    const int64_t edge_rows[4] =
+    {
+        (int64_t)params->row_begin - 2, (int64_t)params->row_begin - 1,
+        (int64_t)params->row_end, (int64_t)params->row_end + 1,
+    };
+    for (size_t r = 0; r != 4; ++r)
+    {
+        cell* dst = &edge[r * (CELL_TOT_COL / 8)];
+        if (edge_rows[r] < -1 || edge_rows[r] > (int64_t)params->rows)
+            memset(dst, 0, CELL_TOT_COL / 8);
+        else
+            copy_row(dst, &grid[get_byte_idx(edge_rows[r], -1)], params->cols);
+    }
+}
+
+// Wakes the workers, updates the first band on this thread,
+// and waits for the others.
+void
+update_bands(thread_info* info)
+{
+    // Awake all threads
+    pthread_mutex_lock(info->cv_mtx);
+    (*info->round)++;
+    pthread_cond_broadcast(info->cv);
+    pthread_mutex_unlock(info->cv_mtx);
+
+    update_band(&info->params[0]);
+
+    // Just spinning in place, as the threads are given the same amount of work
+    // they should not be that far away from each other in terms of time.
+    int expected = THREAD_COUNT - 1;
+    while (!atomic_compare_exchange_weak_explicit(info->signal,
+                                                  &expected,
+                                                  0,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+    {
+        expected = THREAD_COUNT - 1;
+    }
+
+    build_summed_area(info->tiles);
+}
+
+// Advances the grid 1 or 2 generations.
+void
+update_grid(thread_info* info,
+            const size_t generations)
+{
+    // memcpy in all buffers where races might occur
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        thread_params* params = &info->params[i];
+        params->generations = generations;
+        params->twin = NULL;
+        params->damage_pass = false;
+
+        if (generations == 2)
+        {
+            copy_band_edges(params->edge_buffer, params->grid, params);
+            continue;
+        }
+
+        const size_t above_row = get_byte_idx((int64_t)info->params[i].row_begin - 1, -1);
+        copy_row(info->params[i].above_buffer,
+                 &info->params[0].grid[above_row],
+                 info->params[i].cols);
+
+        const size_t border_row = get_byte_idx((int64_t)info->params[i].row_end, -1);
+        copy_row(info->params[i].border_buffer,
+                 &info->params[0].grid[border_row],
+                 info->params[i].cols);
+    }
+
+    update_bands(info);
+}
+
+///////////////////////////////////////////////////////////
+/// Damage
+///////////////////////////////////////////////////////////
+// Damage spreading: a twin of the grid with one cell flipped is
+// stepped alongside it, and their Hamming distance is reported
+// every generation.
+// Both grids are stepped in one fused pass (sub_update_damage),
+// split into the same bands and threads as update_grid.
+// Each band returns its own distance, and they are summed once
+// all bands are done. The pass also recounts the tile populations
+// of the grid.
+typedef struct
+{
+    cell* twin;
+    uint64_t start;
+    size_t distance;
+} damage_state;
+
+damage_state*
+create_damage(const cell* grid,
+              const size_t rows,
+              const size_t cols,
+              const uint64_t generation)
+{
+    const size_t size = (rows + CELL_ROW_OFFSET * 2) * ((cols + CELL_COL_OFFSET * 2) / 8);
+
+    damage_state* dmg = malloc(sizeof(damage_state));
+    dmg->twin = malloc(size);
+    memcpy(dmg->twin, grid, size);
+    dmg->start = generation;
+    dmg->distance = 1;
+
+    // The perturbation, the center cell of the twin
+    const size_t row = rows / 2;
+    const size_t col = cols / 2;
+    set_cell(dmg->twin, row, col, !get_cell(grid, row, col));
+
+    printf("damage: flipped cell (%zu, %zu) at generation %lu\n",
+           row, col, (unsigned long)generation);
+    return dmg;
+}
+
+void
+destroy_damage(damage_state* dmg)
+{
+    free(dmg->twin);
+    free(dmg);
+}
+
+// Steps the grid and the twin one generation, returns their distance.
+size_t
+update_grid_damage(thread_info* info,
+                   damage_state* dmg)
+{
+    const size_t row_bytes = CELL_TOT_COL / 8;
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        thread_params* params = &info->params[i];
+        params->generations = 1;
+        params->twin = dmg->twin;
+        copy_band_edges(params->edge_buffer, params->grid, params);
+        copy_band_edges(params->edge_buffer + 4 * row_bytes, dmg->twin, params);
+    }
+
+    update_bands(info);
+
+    size_t distance = 0;
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        distance += info->params[i].distance;
+        info->params[i].twin = NULL;
+    }
+
+    dmg->distance = distance;
+    return distance;
+}
+
+// Steps the grid one generation through the damage pass without a
+// twin, what damage mode costs against.
+void
+update_grid_damage_pass(thread_info* info)
+{
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        thread_params* params = &info->params[i];
+        params->generations = 1;
+        params->twin = NULL;
+        params->damage_pass = true;
+        copy_band_edges(params->edge_buffer, params->grid, params);
+    }
+
+    update_bands(info);
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        info->params[i].damage_pass = false;
+}
+
+// Cells where the twin differs from the grid, drawn over the grid.
+void
+draw_damage(const damage_state* dmg,
+            const cell* grid,
+            const size_t rows,
+            const size_t cols,
+            SDL_Renderer* renderer)
+{
+    SDL_Color prev_color;
+    SDL_GetRenderDrawColor(renderer,
+                           &prev_color.r,
+                           &prev_color.g,
+                           &prev_color.b,
+                           &prev_color.a);
+
+    SDL_SetRenderDrawColor(renderer, 255, 64, 0, 255);
+
+    bool cells[CELL_COL_COUNT];
+    bool twin_cells[CELL_COL_COUNT];
+    for (size_t i = 0; i != rows; ++i)
+    {
+        unpack_row(cells, &grid[get_byte_idx(i, -1)], cols);
+        unpack_row(twin_cells, &dmg->twin[get_byte_idx(i, -1)], cols);
+        for (size_t j = 0; j != cols; ++j)
+        {
+            if (cells[j] != twin_cells[j])
+            {
+                SDL_Rect rect =
+                {
+                    .x = j * CELL_WIDTH + BORDER_WIDTH,
+                    .y = i * CELL_HEIGHT + BORDER_WIDTH,
+                    .w = CELL_WIDTH - (BORDER_WIDTH * 2),
+                    .h = CELL_HEIGHT - (BORDER_WIDTH * 2),
+                };
+
+                SDL_RenderFillRect(renderer, &rect);
+            }
+        }
+    }
+
+    SDL_SetRenderDrawColor(renderer,
+                           prev_color.r,
+                           prev_color.g,
+                           prev_color.b,
+                           prev_color.a);
+}
+
+///////////////////////////////////////////////////////////
+/// Recording
+///////////////////////////////////////////////////////////
+// Checkpoints and recordings are written by a separate writer thread,
+// the simulation only copies the grid into a free slot and moves on.
+// If every slot is still waiting on the disk the frame is dropped
+// rather than stalling the simulation, the drop count is reported
+// when the recorder is destroyed.
+//
+// File layout:
+// - One RECORD_ALIGNMENT sized header block (record_header).
+// - Frames of slot_size bytes, each starting with the generation
+//   as an uint64_t, followed by the raw grid (including borders).
+//
+// The writer uses io_uring with registered buffers and O_DIRECT
+// when the kernel and file system allow it, keeping all slots in
+// flight at once. Otherwise it falls back to pwrite from the writer
+// thread, so the simulation threads are never blocked either way.
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t frame_size;
+    uint64_t slot_size;
+} record_header;
+
+enum
+{
+    SLOT_FREE,
+    SLOT_FILLED,
+    SLOT_IN_USE,
+};
+
+#ifdef RECORD_USE_IO_URING
+// Minimal io_uring wrapper using raw syscalls,
+// to avoid depending on liburing.
+typedef struct
+{
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ptr;
+    size_t sq_len;
+    void* cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+} uring;
+
+bool
+uring_init(uring* ring,
+           const unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(ring, 0, sizeof(*ring));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+        return false;
+
+    ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ring->sq_ptr == MAP_FAILED ||
+        ring->cq_ptr == MAP_FAILED ||
+        ring->sqes == MAP_FAILED)
+    {
+        if (ring->sq_ptr != MAP_FAILED)
+            munmap(ring->sq_ptr, ring->sq_len);
+        if (ring->cq_ptr != MAP_FAILED)
+            munmap(ring->cq_ptr, ring->cq_len);
+        if (ring->sqes != MAP_FAILED)
+            munmap(ring->sqes, ring->sqes_len);
+        close(ring->fd);
+        return false;
+    }
+
+    char* sq = ring->sq_ptr;
+    ring->sq_head = (unsigned*)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + p.sq_off.array);
+
+    char* cq = ring->cq_ptr;
+    ring->cq_head = (unsigned*)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    return true;
+}
+
+void
+uring_shutdown(uring* ring)
+{
+    munmap(ring->sqes, ring->sqes_len);
+    munmap(ring->cq_ptr, ring->cq_len);
+    munmap(ring->sq_ptr, ring->sq_len);
+    close(ring->fd);
+}
+
+bool
+uring_register_buffers(uring* ring,
+                       const struct iovec* iovecs,
+                       const unsigned count)
+{
+    return syscall(__NR_io_uring_register, ring->fd,
+                   IORING_REGISTER_BUFFERS, iovecs, count) == 0;
+}
+
+// Queues a write, buf_index < 0 means the buffer is not registered.
+void
+uring_queue_write(uring* ring,
+                  const int fd,
+                  const void* buf,
+                  const unsigned len,
+                  const uint64_t offset,
+                  const int buf_index,
+                  const uint64_t user_data)
+{
+    const unsigned tail = *ring->sq_tail;
+    const unsigned idx = tail & *ring->sq_mask;
+
+    struct io_uring_sqe* sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (buf_index < 0) ? IORING_OP_WRITE : IORING_OP_WRITE_FIXED;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->buf_index = (buf_index < 0) ? 0 : buf_index;
+    sqe->user_data = user_data;
+
+    ring->sq_array[idx] = idx;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Takes back the last queued write, which the kernel has not
+// consumed yet, and returns its user data.
+uint64_t
+uring_unqueue_write(uring* ring)
+{
+    const unsigned tail = *ring->sq_tail - 1;
+    const uint64_t user_data = ring->sqes[tail & *ring->sq_mask].user_data;
+    __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+    return user_data;
+}
+
+// Submits queued writes and waits for at least min_complete of them.
+// Returns the number of writes submitted, or -1 and sets errno.
+int
+uring_enter(uring* ring,
+            const unsigned to_submit,
+            const unsigned min_complete)
+{
+    const unsigned flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+    return syscall(__NR_io_uring_enter, ring->fd, to_submit,
+                   min_complete, flags, NULL, 0);
+}
+
+bool
+uring_pop_completion(uring* ring,
+                     uint64_t* out_user_data,
+                     int* out_res)
+{
+    const unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+        return false;
+
+    const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+    (*out_user_data) = cqe->user_data;
+    (*out_res) = cqe->res;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+#endif
+
+typedef struct
+{
+    int fd;
+    size_t frame_size;
+    size_t slot_size;
+    size_t frame_count;
+    size_t dropped;
+    size_t failed;
+
+    // All slots live in one aligned allocation,
+    // so they can be registered with the ring in one go.
+    uint8_t* slot_memory;
+    uint64_t offsets[RECORD_SLOT_COUNT];
+    atomic_int states[RECORD_SLOT_COUNT];
+
+#ifdef RECORD_USE_IO_URING
+    uring ring;
+    bool ring_open;
+    // Cleared if the kernel rejects ring writes, pwrite takes over.
+    bool use_ring;
+    bool registered;
+#endif
+
+    // Synchronization vars
+    atomic_bool running;
+    atomic_int pending;
+    pthread_cond_t cv;
+    pthread_mutex_t cv_mtx;
+    pthread_t thread;
+} recorder;
+
+size_t
+round_up(const size_t size,
+         const size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+uint8_t*
+get_slot(recorder* rec,
+         const size_t slot)
+{
+    return rec->slot_memory + slot * rec->slot_size;
+}
+
+// Writes the remaining part of a slot synchronously.
+// Only called from the writer thread.
+void
+write_slot_remainder(recorder* rec,
+                     const size_t slot,
+                     size_t written)
+{
+    const uint8_t* data = get_slot(rec, slot);
+    while (written < rec->slot_size)
+    {
+        const ssize_t res = pwrite(rec->fd, data + written,
+                                   rec->slot_size - written,
+                                   rec->offsets[slot] + written);
+        if (res <= 0)
+        {
+            rec->failed++;
+            return;
+        }
+        written += res;
+    }
+}
+
+void
+release_slot(recorder* rec,
+             const size_t slot)
+{
+    atomic_store_explicit(&rec->states[slot],
+                          SLOT_FREE,
+                          memory_order_release);
+    atomic_fetch_sub_explicit(&rec->pending, 1, memory_order_relaxed);
+}
+
+void*
+recorder_execution(void* params)
+{
+    recorder* rec = (recorder*)params;
+    // Queued writes the kernel has not taken yet, and those it has
+    unsigned unsubmitted = 0;
+    size_t in_flight = 0;
+
+    while (true)
+    {
+        // Pending also counts the frames in flight,
+        // so we only sleep when there is nothing left to do.
+        pthread_mutex_lock(&rec->cv_mtx);
+        while (atomic_load_explicit(&rec->pending, memory_order_relaxed) == 0 &&
+               atomic_load_explicit(&rec->running, memory_order_relaxed))
+        {
+            pthread_cond_wait(&rec->cv, &rec->cv_mtx);
+        }
+        pthread_mutex_unlock(&rec->cv_mtx);
+
+        if (atomic_load_explicit(&rec->pending, memory_order_relaxed) == 0)
+            break;
+
+        unsigned queued = 0;
+        for (size_t i = 0; i != RECORD_SLOT_COUNT; ++i)
+        {
+            if (atomic_load_explicit(&rec->states[i], memory_order_acquire) != SLOT_FILLED)
+                continue;
+
+            atomic_store_explicit(&rec->states[i], SLOT_IN_USE,
+                                  memory_order_relaxed);
+
+#ifdef RECORD_USE_IO_URING
+            if (rec->use_ring)
+            {
+                // A longer slot completes short and is finished by pwrite
+                const size_t len = (rec->slot_size < RECORD_MAX_WRITE) ? rec->slot_size : RECORD_MAX_WRITE;
+                uring_queue_write(&rec->ring, rec->fd, get_slot(rec, i),
+                                  len, rec->offsets[i],
+                                  rec->registered ? (int)i : -1, i);
+                queued++;
+                continue;
+            }
+#endif
+            write_slot_remainder(rec, i, 0);
+            release_slot(rec, i);
+        }
+
+#ifdef RECORD_USE_IO_URING
+        // A short submit leaves the rest queued for the next try.
+        // If the kernel takes nothing (-EAGAIN, -EBUSY), the writes in
+        // flight are waited for below, which frees it up.
+        unsubmitted += queued;
+        size_t tries = 0;
+        while (unsubmitted != 0)
+        {
+            const int submitted = uring_enter(&rec->ring, unsubmitted, 0);
+            if (submitted < 0 && errno == EINTR)
+                continue;
+            if (submitted > 0)
+            {
+                unsubmitted -= submitted;
+                in_flight += submitted;
+                continue;
+            }
+            if (in_flight != 0 || ++tries == RECORD_SUBMIT_TRIES)
+                break;
+        }
+
+        // Nothing in flight to wait for, those frames go through pwrite from now on
+        if (unsubmitted != 0 && in_flight == 0)
+        {
+            rec->use_ring = false;
+            for (; unsubmitted != 0; --unsubmitted)
+            {
+                const size_t slot = uring_unqueue_write(&rec->ring);
+                write_slot_remainder(rec, slot, 0);
+                release_slot(rec, slot);
+            }
+        }
+
+        if (in_flight != 0)
+        {
+            // Wait for at least one write,
+            // frames arriving meanwhile are picked up on the next pass.
+            while (uring_enter(&rec->ring, 0, 1) < 0 && errno == EINTR)
+                continue;
+
+            uint64_t slot;
+            int res;
+            while (uring_pop_completion(&rec->ring, &slot, &res))
+            {
+                if (res < 0)
+                {
+                    // Older kernels can set up a ring but not write with it,
+                    // or not to an O_DIRECT file, those frames go through pwrite.
+                    if (res == -EINVAL || res == -EOPNOTSUPP)
+                        rec->use_ring = false;
+                    write_slot_remainder(rec, slot, 0);
+                }
+                else if ((size_t)res < rec->slot_size)
+                    write_slot_remainder(rec, slot, res);
+
+                release_slot(rec, slot);
+                in_flight--;
+            }
+        }
+#else
+        (void)queued;
+        (void)unsubmitted;
+        (void)in_flight;
+#endif
+    }
+
+    return NULL;
+}
+
+recorder*
+create_recorder(const char* path,
+                const size_t rows,
+                const size_t cols,
+                const size_t frame_size)
+{
+    recorder* rec = calloc(1, sizeof(recorder));
+    rec->frame_size = frame_size;
+    rec->slot_size = round_up(sizeof(uint64_t) + frame_size, RECORD_ALIGNMENT);
+
+    rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (rec->fd < 0)
+        rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (rec->fd < 0)
     {
-        .running = malloc(sizeof(atomic_bool)),
-        .signal = malloc(sizeof(atomic_int)),
-        .cv = malloc(sizeof(pthread_cond_t)),
-        .cv_mtx = malloc(sizeof(pthread_mutex_t)),
-        .threads = malloc((THREAD_COUNT - 1) * sizeof(pthread_t)),
-        .params = malloc((THREAD_COUNT) * sizeof(thread_params)),
-    };
+        perror("create_recorder");
+        free(rec);
+        return NULL;
+    }
 
-    atomic_init(info.running, true);
-    atomic_init(info.signal, 0);
-    pthread_cond_init(info.cv, NULL);
-    pthread_mutex_init(info.cv_mtx, NULL);
+    rec->slot_memory = aligned_alloc(RECORD_ALIGNMENT,
+                                     rec->slot_size * RECORD_SLOT_COUNT);
+    memset(rec->slot_memory, 0, rec->slot_size * RECORD_SLOT_COUNT);
+
+    // Header is written synchronously, before any frames exist.
+    record_header* header = (record_header*)get_slot(rec, 0);
+    memcpy(header->magic, "GOLR", 4);
+    header->version = 1;
+    header->rows = rows;
+    header->cols = cols;
+    header->frame_size = rec->frame_size;
+    header->slot_size = rec->slot_size;
+
+    if (pwrite(rec->fd, header, RECORD_ALIGNMENT, 0) != RECORD_ALIGNMENT)
+        rec->failed++;
+    memset(header, 0, sizeof(record_header));
+
+    for (size_t i = 0; i != RECORD_SLOT_COUNT; ++i)
+        atomic_init(&rec->states[i], SLOT_FREE);
+
+#ifdef RECORD_USE_IO_URING
+    rec->ring_open = uring_init(&rec->ring, RECORD_SLOT_COUNT);
+    rec->use_ring = rec->ring_open;
+    if (rec->ring_open)
+    {
+        struct iovec iovecs[RECORD_SLOT_COUNT];
+        for (size_t i = 0; i != RECORD_SLOT_COUNT; ++i)
+        {
+            iovecs[i].iov_base = get_slot(rec, i);
+            iovecs[i].iov_len = rec->slot_size;
+        }
+        rec->registered = uring_register_buffers(&rec->ring, iovecs,
+                                                 RECORD_SLOT_COUNT);
+    }
+#endif
 
-    // Initialize threads and start execution
-    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    atomic_init(&rec->running, true);
+    atomic_init(&rec->pending, 0);
+    pthread_cond_init(&rec->cv, NULL);
+    pthread_mutex_init(&rec->cv_mtx, NULL);
+    pthread_create(&rec->thread, NULL, recorder_execution, rec);
+
+    return rec;
+}
+
+// Copies the grid into a free slot and hands it to the writer.
+// Never waits on the disk, returns false if the frame was dropped.
+// The file offset comes from the frame number, so any free slot will do.
+bool
+record_frame(recorder* rec,
+             const cell* grid,
+             const uint64_t generation)
+{
+    size_t slot = RECORD_SLOT_COUNT;
+    for (size_t i = 0; i != RECORD_SLOT_COUNT; ++i)
     {
-        info.params[i].grid = grid;
-        info.params[i].row_begin = (rows / THREAD_COUNT) * i;
-        info.params[i].row_end = (rows / THREAD_COUNT) * (i + 1);
-        info.params[i].cols = cols;
-        info.params[i].running = info.running;
-        info.params[i].signal = info.signal;
-        info.params[i].cv = info.cv;
-        info.params[i].cv_mtx = info.cv_mtx;
-        info.params[i].id = i;
+        const size_t candidate = (rec->frame_count + i) % RECORD_SLOT_COUNT;
+        if (atomic_load_explicit(&rec->states[candidate], memory_order_acquire) == SLOT_FREE)
+        {
+            slot = candidate;
+            break;
+        }
+    }
 
-        info.params[i].above_buffer = create_row(CELL_COL_COUNT);
-        info.params[i].current_buffer = create_row(CELL_COL_COUNT);
-        info.params[i].border_buffer = create_row(CELL_COL_COUNT);
+    if (slot == RECORD_SLOT_COUNT)
+    {
+        rec->dropped++;
+        return false;
     }
 
+    uint8_t* data = get_slot(rec, slot);
+    memcpy(data, &generation, sizeof(uint64_t));
+    memcpy(data + sizeof(uint64_t), grid, rec->frame_size);
+    rec->offsets[slot] = RECORD_ALIGNMENT + rec->frame_count * rec->slot_size;
+    rec->frame_count++;
 
-    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
-        pthread_create(&info.threads[i], NULL, thread_execution, &info.params[i + 1]);
+    atomic_store_explicit(&rec->states[slot], SLOT_FILLED,
+                          memory_order_release);
 
-    return info;
+    pthread_mutex_lock(&rec->cv_mtx);
+    atomic_fetch_add_explicit(&rec->pending, 1, memory_order_relaxed);
+    pthread_cond_signal(&rec->cv);
+    pthread_mutex_unlock(&rec->cv_mtx);
+
+    return true;
 }
 
+// Waits for all outstanding frames to reach the file.
 void
-destroy_threads(thread_info* info)
+destroy_recorder(recorder* rec)
 {
-    atomic_store_explicit(info->running, false, memory_order_release);
-    pthread_cond_broadcast(info->cv);
+    pthread_mutex_lock(&rec->cv_mtx);
+    atomic_store_explicit(&rec->running, false, memory_order_release);
+    pthread_cond_signal(&rec->cv);
+    pthread_mutex_unlock(&rec->cv_mtx);
 
-    for (size_t i = 0; i != THREAD_COUNT - 1; ++i)
-        pthread_join(info->threads[i], NULL);
+    pthread_join(rec->thread, NULL);
 
-    for (size_t i = 0; i != THREAD_COUNT; ++i)
+#ifdef RECORD_USE_IO_URING
+    if (rec->ring_open)
+        uring_shutdown(&rec->ring);
+#endif
+
+    printf("recorded frames: %zu, dropped: %zu, failed writes: %zu\n",
+           rec->frame_count - rec->failed, rec->dropped, rec->failed);
+
+    pthread_cond_destroy(&rec->cv);
+    pthread_mutex_destroy(&rec->cv_mtx);
+    close(rec->fd);
+    free(rec->slot_memory);
+    free(rec);
+}
+
+///////////////////////////////////////////////////////////
+/// Tracking
+///////////////////////////////////////////////////////////
+// Follows small objects (gliders, spaceships, oscillators) across
+// generations. The simulation only copies the grid into a free
+// snapshot slot, labeling and matching happen on the tracker thread.
+//
+// Components are matched to the objects of the previous snapshot
+// by overlapping bounding boxes (an object moves at most one cell
+// per generation), preferring an unchanged shape, then the closest one.
+// Each object keeps a short history of shape hashes and positions,
+// once a shape repeats the distance in generations is its period,
+// and the distance moved its velocity.
+typedef struct
+{
+    uint64_t generation;
+    uint64_t hash;
+    size_t row;
+    size_t col;
+} track_sample;
+
+typedef struct
+{
+    size_t id;
+    component box;
+    uint64_t hash;
+    uint64_t first_generation;
+
+    // Ring buffer of the latest samples
+    track_sample history[TRACK_MAX_PERIOD];
+    size_t history_count;
+
+    // Zero until the object has repeated itself
+    size_t period;
+    int64_t row_shift;
+    int64_t col_shift;
+} tracked_object;
+
+typedef struct
+{
+    size_t frame_size;
+    size_t rows;
+    size_t cols;
+    cell* slot_memory;
+    uint64_t generations[TRACK_SLOT_COUNT];
+    atomic_int states[TRACK_SLOT_COUNT];
+    size_t produced;
+    size_t consumed;
+    size_t dropped;
+
+    // Only touched by the tracker thread
+    const object_dictionary* dict;
+    tracked_object* objects;
+    size_t object_count;
+    tracked_object* next_objects;
+    size_t object_capacity;
+    bool* matched;
+    size_t matched_capacity;
+    size_t next_id;
+    uint64_t first_generation;
+    uint64_t last_generation;
+    size_t still_lifes;
+    size_t oscillators;
+    size_t spaceships;
+
+    // Synchronization vars
+    atomic_bool running;
+    atomic_int pending;
+    pthread_cond_t cv;
+    pthread_mutex_t cv_mtx;
+    pthread_t thread;
+} tracker;
+
+// Translation invariant hash of each component's cells,
+// computed from its runs relative to the bounding box.
+void
+hash_components(const component_labels* labels,
+                uint64_t* hashes)
+{
+    for (size_t i = 0; i != labels->component_count; ++i)
     {
-        free(info->params[i].above_buffer);
-        free(info->params[i].current_buffer);
-        free(info->params[i].border_buffer);
+        const component* comp = &labels->components[i];
+        hashes[i] = hash_combine(comp->row_end - comp->row_begin,
+                                 comp->col_end - comp->col_begin);
     }
 
-    pthread_cond_destroy(info->cv);
-    pthread_mutex_destroy(info->cv_mtx);
-    free(info->running);
-    free(info->signal);
-    free(info->cv);
-    free(info->cv_mtx);
-    free(info->threads);
-    free(info->params);
+    for (size_t r = 0; r != labels->run_count; ++r)
+    {
+        const cell_run* run = &labels->runs[r];
+        const component* comp = &labels->components[run->label];
+        const size_t col_begin = comp->col_begin + CELL_COL_OFFSET;
+
+        uint64_t* hash = &hashes[run->label];
+        (*hash) = hash_combine((*hash), run->row - comp->row_begin);
+        (*hash) = hash_combine((*hash), run->begin - col_begin);
+        (*hash) = hash_combine((*hash), run->end - col_begin);
+    }
+}
+
+bool
+is_trackable(const component* comp)
+{
+    return comp->row_end - comp->row_begin <= TRACK_MAX_SIZE &&
+           comp->col_end - comp->col_begin <= TRACK_MAX_SIZE;
+}
+
+size_t
+distance(const size_t a,
+         const size_t b)
+{
+    return (a < b) ? b - a : a - b;
 }
 
+// Looks for an earlier sample with the same shape,
+// the closest one gives the period and displacement.
 void
-update_grid(thread_info* info)
+detect_period(tracker* tr,
+              tracked_object* obj,
+              const component_labels* labels,
+              const size_t index)
 {
-    // memcpy in all buffers where races might occur
-    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    if (obj->period != 0)
+        return;
+
+    const track_sample* latest = &obj->history[(obj->history_count - 1) % TRACK_MAX_PERIOD];
+    const size_t sample_count = (obj->history_count < TRACK_MAX_PERIOD)
+                              ? obj->history_count
+                              : TRACK_MAX_PERIOD;
+
+    const track_sample* match = NULL;
+    for (size_t i = 0; i != sample_count; ++i)
     {
-        const int above_row = get_byte_idx((int)info->params[i].row_begin - 1, -1);
-        copy_row(info->params[i].above_buffer,
-                 &info->params[0].grid[above_row],
-                 info->params[i].cols);
+        const track_sample* sample = &obj->history[i];
+        if (sample == latest || sample->hash != latest->hash)
+            continue;
 
-        const int border_row = get_byte_idx((int)info->params[i].row_end, -1);
-        copy_row(info->params[i].border_buffer,
-                 &info->params[0].grid[border_row],
-                 info->params[i].cols);
+        if (!match || sample->generation > match->generation)
+            match = sample;
     }
 
-    // Awake all threads
-    pthread_cond_broadcast(info->cv);
+    if (!match)
+        return;
 
-    sub_update(info->params[0].grid, info->params[0].above_buffer,
-               info->params[0].current_buffer, info->params[0].border_buffer,
-               info->params[0].row_begin, info->params[0].row_end,
-               info->params[0].cols, info->params[0].id);
+    obj->period = latest->generation - match->generation;
+    obj->row_shift = (int64_t)latest->row - (int64_t)match->row;
+    obj->col_shift = (int64_t)latest->col - (int64_t)match->col;
 
-    // Just spinning in place, as the threads are given the same amount of work
-    // they should not be that far away from each other in terms of time.
-    int expected = THREAD_COUNT - 1;
-    while (!atomic_compare_exchange_weak_explicit(info->signal,
-                                                  &expected,
-                                                  0,
-                                                  memory_order_acquire,
-                                                  memory_order_relaxed))
+    if (obj->row_shift != 0 || obj->col_shift != 0)
     {
-        expected = THREAD_COUNT - 1;
+        const known_object* known = identify_component(tr->dict, labels, index);
+        tr->spaceships++;
+        printf("spaceship %zu (%s): period %zu, moving (%ld, %ld), at row %zu, col %zu, generation %lu\n",
+               obj->id, known ? known->name : "unknown", obj->period,
+               (long)obj->row_shift, (long)obj->col_shift,
+               latest->row, latest->col,
+               (unsigned long)latest->generation);
+    }
+    else if (obj->period == 1)
+    {
+        tr->still_lifes++;
+    }
+    else
+    {
+        tr->oscillators++;
+    }
+}
+
+void
+push_sample(tracked_object* obj,
+            const uint64_t generation)
+{
+    obj->history[obj->history_count % TRACK_MAX_PERIOD] = (track_sample)
+    {
+        .generation = generation,
+        .hash = obj->hash,
+        .row = obj->box.row_begin,
+        .col = obj->box.col_begin,
+    };
+    obj->history_count++;
+}
+
+void
+track_snapshot(tracker* tr,
+               const cell* grid,
+               const uint64_t generation)
+{
+    component_labels labels = label_components(grid, tr->rows, tr->cols, 1);
+    uint64_t* hashes = malloc((labels.component_count + 1) * sizeof(uint64_t));
+    hash_components(&labels, hashes);
+
+    // Both lists share a capacity so they can be swapped afterwards
+    if (tr->object_capacity < labels.component_count)
+    {
+        tr->object_capacity = labels.component_count;
+        tr->objects = realloc(tr->objects, tr->object_capacity * sizeof(tracked_object));
+        tr->next_objects = realloc(tr->next_objects, tr->object_capacity * sizeof(tracked_object));
+    }
+
+    if (tr->matched_capacity < tr->object_count + 1)
+    {
+        tr->matched_capacity = tr->object_count + 1;
+        tr->matched = realloc(tr->matched, tr->matched_capacity * sizeof(bool));
+    }
+    memset(tr->matched, 0, tr->object_count * sizeof(bool));
+
+    // Objects and components are both sorted by their first row,
+    // so candidates are found within a sliding window.
+    const size_t slack = (tr->object_count != 0) ? generation - tr->last_generation : 0;
+    size_t window_begin = 0;
+    size_t next_count = 0;
+
+    for (size_t i = 0; i != labels.component_count; ++i)
+    {
+        const component* comp = &labels.components[i];
+        if (!is_trackable(comp))
+            continue;
+
+        while (window_begin != tr->object_count &&
+               tr->objects[window_begin].box.row_begin + TRACK_MAX_SIZE + slack < comp->row_begin)
+        {
+            ++window_begin;
+        }
+
+        tracked_object* best = NULL;
+        size_t best_score = SIZE_MAX;
+        for (size_t j = window_begin; j != tr->object_count; ++j)
+        {
+            tracked_object* obj = &tr->objects[j];
+            if (obj->box.row_begin > comp->row_end + slack)
+                break;
+
+            if (tr->matched[j] ||
+                obj->box.row_end + slack < comp->row_begin ||
+                obj->box.col_end + slack < comp->col_begin ||
+                obj->box.col_begin > comp->col_end + slack)
+            {
+                continue;
+            }
+
+            const size_t score = (obj->hash != hashes[i]) * (TRACK_MAX_SIZE * 8) +
+                                 distance(obj->box.row_begin + obj->box.row_end,
+                                          comp->row_begin + comp->row_end) +
+                                 distance(obj->box.col_begin + obj->box.col_end,
+                                          comp->col_begin + comp->col_end);
+            if (score < best_score)
+            {
+                best = obj;
+                best_score = score;
+            }
+        }
+
+        tracked_object* next = &tr->next_objects[next_count++];
+        if (best)
+        {
+            tr->matched[best - tr->objects] = true;
+            (*next) = (*best);
+        }
+        else
+        {
+            memset(next, 0, sizeof(tracked_object));
+            next->id = tr->next_id++;
+            next->first_generation = generation;
+        }
+
+        next->box = (*comp);
+        next->hash = hashes[i];
+        push_sample(next, generation);
+        detect_period(tr, next, &labels, i);
+    }
+
+    tracked_object* tmp = tr->objects;
+    tr->objects = tr->next_objects;
+    tr->next_objects = tmp;
+    tr->object_count = next_count;
+
+    tr->last_generation = generation;
+    free(hashes);
+    destroy_component_labels(&labels);
+}
+
+void*
+tracker_execution(void* params)
+{
+    tracker* tr = (tracker*)params;
+    while (true)
+    {
+        pthread_mutex_lock(&tr->cv_mtx);
+        while (atomic_load_explicit(&tr->pending, memory_order_relaxed) == 0 &&
+               atomic_load_explicit(&tr->running, memory_order_relaxed))
+        {
+            pthread_cond_wait(&tr->cv, &tr->cv_mtx);
+        }
+        pthread_mutex_unlock(&tr->cv_mtx);
+
+        if (atomic_load_explicit(&tr->pending, memory_order_relaxed) == 0)
+            break;
+
+        // Slots are filled in order, so they are consumed in order.
+        const size_t slot = tr->consumed % TRACK_SLOT_COUNT;
+        if (atomic_load_explicit(&tr->states[slot], memory_order_acquire) != SLOT_FILLED)
+            continue;
+
+        track_snapshot(tr, tr->slot_memory + slot * tr->frame_size,
+                       tr->generations[slot]);
+
+        tr->consumed++;
+        atomic_store_explicit(&tr->states[slot], SLOT_FREE, memory_order_release);
+        atomic_fetch_sub_explicit(&tr->pending, 1, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+tracker*
+create_tracker(const object_dictionary* dict,
+               const size_t rows,
+               const size_t cols,
+               const size_t frame_size,
+               const uint64_t generation)
+{
+    tracker* tr = calloc(1, sizeof(tracker));
+    tr->dict = dict;
+    tr->frame_size = frame_size;
+    tr->rows = rows;
+    tr->cols = cols;
+    tr->slot_memory = malloc(frame_size * TRACK_SLOT_COUNT);
+    tr->first_generation = generation;
+    tr->last_generation = generation;
+
+    for (size_t i = 0; i != TRACK_SLOT_COUNT; ++i)
+        atomic_init(&tr->states[i], SLOT_FREE);
+
+    atomic_init(&tr->running, true);
+    atomic_init(&tr->pending, 0);
+    pthread_cond_init(&tr->cv, NULL);
+    pthread_mutex_init(&tr->cv_mtx, NULL);
+    pthread_create(&tr->thread, NULL, tracker_execution, tr);
+
+    return tr;
+}
+
+// Hands a copy of the grid to the tracker thread.
+// Never waits, returns false if the snapshot was dropped.
+bool
+track_frame(tracker* tr,
+            const cell* grid,
+            const uint64_t generation)
+{
+    const size_t slot = tr->produced % TRACK_SLOT_COUNT;
+    if (atomic_load_explicit(&tr->states[slot], memory_order_acquire) != SLOT_FREE)
+    {
+        tr->dropped++;
+        return false;
     }
 
+    memcpy(tr->slot_memory + slot * tr->frame_size, grid, tr->frame_size);
+    tr->generations[slot] = generation;
+    tr->produced++;
+
+    atomic_store_explicit(&tr->states[slot], SLOT_FILLED, memory_order_release);
+
+    pthread_mutex_lock(&tr->cv_mtx);
+    atomic_fetch_add_explicit(&tr->pending, 1, memory_order_relaxed);
+    pthread_cond_signal(&tr->cv);
+    pthread_mutex_unlock(&tr->cv_mtx);
+
+    return true;
+}
+
+// Finishes the queued snapshots and prints a summary.
+void
+destroy_tracker(tracker* tr)
+{
+    pthread_mutex_lock(&tr->cv_mtx);
+    atomic_store_explicit(&tr->running, false, memory_order_release);
+    pthread_cond_signal(&tr->cv);
+    pthread_mutex_unlock(&tr->cv_mtx);
+
+    pthread_join(tr->thread, NULL);
+
+    const uint64_t generations = tr->last_generation - tr->first_generation;
+    printf("tracked generations: %lu, dropped snapshots: %zu\n",
+           (unsigned long)generations, tr->dropped);
+    printf("still lifes: %zu, oscillators: %zu, spaceships: %zu\n",
+           tr->still_lifes, tr->oscillators, tr->spaceships);
+    if (generations != 0)
+        printf("spaceships per 1000 generations: %.2f\n",
+               tr->spaceships * 1000.0 / generations);
+
+    pthread_cond_destroy(&tr->cv);
+    pthread_mutex_destroy(&tr->cv_mtx);
+    free(tr->slot_memory);
+    free(tr->objects);
+    free(tr->next_objects);
+    free(tr->matched);
+    free(tr);
+}
+
+///////////////////////////////////////////////////////////
+/// Benchmark
+///////////////////////////////////////////////////////////
+double
+get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Steps a soup with update_grid, one and two generations at a time,
+// then the soup and a twin with one cell flipped in damage mode. The perturbed soup is stepped with
+// update_grid as well, to check both grids and the distance.
+int
+run_benchmark(int argc,
+              char** argv)
+{
+    const size_t generations = (argc > 2) ? strtoul(argv[2], NULL, 10) : 10000;
+    const size_t grid_size = (size_t)CELL_TOT_ROW * (CELL_TOT_COL / 8);
+
+    cell* grid = create_grid(CELL_ROW_COUNT, CELL_COL_COUNT);
+    srand(1);
+    for (size_t i = 0; i != CELL_ROW_COUNT; ++i)
+        for (size_t j = 0; j != CELL_COL_COUNT; ++j)
+            set_cell(grid, i, j, rand() % 3 == 0);
+
+    cell* soup = malloc(grid_size);
+    cell* expected_grid = malloc(grid_size);
+    cell* expected_twin = malloc(grid_size);
+    memcpy(soup, grid, grid_size);
+
+    tile_summary tiles = create_tile_summary(grid);
+    thread_info threads = create_threads(grid, &tiles, CELL_ROW_COUNT, CELL_COL_COUNT);
+
+    double start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid(&threads, 1);
+    const double update_time = get_seconds() - start;
+    memcpy(expected_grid, grid, grid_size);
+
+    // The word kernel, two generations per pass
+    memcpy(grid, soup, grid_size);
+    start = get_seconds();
+    for (size_t gen = 0; gen + 2 <= generations; gen += 2)
+        update_grid(&threads, 2);
+    if (generations % 2 != 0)
+        update_grid(&threads, 1);
+    const double update_two_time = get_seconds() - start;
+    bool same = memcmp(grid, expected_grid, grid_size) == 0;
+
+    // The word kernel of damage mode on the grid alone, what damage mode costs against
+    memcpy(grid, soup, grid_size);
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid_damage_pass(&threads);
+    const double pass_time = get_seconds() - start;
+    same &= memcmp(grid, expected_grid, grid_size) == 0;
+
+    memcpy(grid, soup, grid_size);
+    damage_state* dmg = create_damage(grid, CELL_ROW_COUNT, CELL_COL_COUNT, 0);
+    memcpy(soup, dmg->twin, grid_size);
+
+    start = get_seconds();
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid_damage(&threads, dmg);
+    const double damage_time = get_seconds() - start;
+
+    // The grid ends up where it was, the perturbed soup is stepped in its place
+    same &= memcmp(grid, expected_grid, grid_size) == 0;
+    memcpy(grid, soup, grid_size);
+    for (size_t gen = 0; gen != generations; ++gen)
+        update_grid(&threads, 1);
+    memcpy(expected_twin, grid, grid_size);
+
+    size_t distance = 0;
+    for (size_t i = 0; i != grid_size; ++i)
+        distance += __builtin_popcount(expected_grid[i] ^ expected_twin[i]);
+
+    same &= memcmp(dmg->twin, expected_twin, grid_size) == 0;
+    same &= (generations == 0) || distance == dmg->distance;
+
+    const double cells = (double)CELL_ROW_COUNT * CELL_COL_COUNT * generations;
+    printf("%d x %d, soup, %zu generations, %d threads\n",
+           CELL_ROW_COUNT, CELL_COL_COUNT, generations, THREAD_COUNT);
+    printf("update:                %.3f s, %.3f ns/cell\n",
+           update_time, update_time * 1e9 / cells);
+    printf("update, 2 generations: %.3f s, %.3f ns/cell\n",
+           update_two_time, update_two_time * 1e9 / cells);
+    printf("damage pass, one grid: %.3f s, %.3f ns/cell\n",
+           pass_time, pass_time * 1e9 / cells);
+    printf("damage mode:           %.3f s, %.3f ns/cell, %.2fx the pass on one grid, distance %zu\n",
+           damage_time, damage_time * 1e9 / cells, damage_time / pass_time, dmg->distance);
+    printf("results %s\n", same ? "match" : "DIFFER");
+
+    destroy_damage(dmg);
+    destroy_threads(&threads);
+    destroy_tile_summary(&tiles);
+    free(soup);
+    free(expected_grid);
+    free(expected_twin);
+    free(grid);
+    return same ? 0 : 1;
 }
 
 int
 main(int argc, char** argv)
 {
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+        return run_benchmark(argc, argv);
+
     SDL_Window* window;
     SDL_Renderer* renderer;
     if (!sdl_init(&window, &renderer, WINDOW_WIDTH, WINDOW_HEIGHT))
@@ -586,20 +3518,110 @@ main(int argc, char** argv)
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
 
     cell* curr_grid = create_grid(CELL_ROW_COUNT, CELL_COL_COUNT);
+    tile_summary tiles = create_tile_summary(curr_grid);
+    object_dictionary* dict = create_object_dictionary();
 
     thread_info threads = create_threads(curr_grid,
+                                         &tiles,
                                          CELL_ROW_COUNT,
                                          CELL_COL_COUNT);
 
+    const size_t grid_size = (size_t)CELL_TOT_ROW * (CELL_TOT_COL / 8);
+    recorder* recording = NULL;
+    recorder* checkpoints = NULL;
+    tracker* tracking = NULL;
+    damage_state* damage = NULL;
+    uint64_t generation = 0;
+    size_t generations = 1;
+
     bool should_continue = true;
     bool iterate = false;
     while (should_continue)
     {
-        should_continue = handle_events(curr_grid, CELL_ROW_COUNT,
-                                        CELL_COL_COUNT, &iterate);
+        bool toggle_recording = false;
+        bool take_snapshot = false;
+        bool toggle_tracking = false;
+        bool toggle_damage = false;
+        should_continue = handle_events(curr_grid, &tiles, dict,
+                                        CELL_ROW_COUNT, CELL_COL_COUNT, &iterate,
+                                        &toggle_recording, &take_snapshot,
+                                        &toggle_tracking, &toggle_damage,
+                                        &generations);
+
+        if (toggle_damage)
+        {
+            if (damage)
+            {
+                destroy_damage(damage);
+                damage = NULL;
+            }
+            else
+            {
+                damage = create_damage(curr_grid, CELL_ROW_COUNT,
+                                       CELL_COL_COUNT, generation);
+            }
+        }
 
         if (iterate)
-            update_grid(&threads);
+        {
+            // The fused kernel steps the grid as well
+            if (damage)
+            {
+                const size_t distance = update_grid_damage(&threads, damage);
+                generation++;
+                printf("damage: generation %lu, distance %zu\n",
+                       (unsigned long)(generation - damage->start), distance);
+            }
+            else
+            {
+                update_grid(&threads, generations);
+                generation += generations;
+            }
+        }
+
+        if (toggle_recording)
+        {
+            if (recording)
+            {
+                destroy_recorder(recording);
+                recording = NULL;
+            }
+            else
+            {
+                recording = create_recorder("recording.bin", CELL_TOT_ROW,
+                                            CELL_TOT_COL, grid_size);
+            }
+        }
+
+        // Workers are idle between updates, so the grid is consistent here.
+        if (recording && (iterate || toggle_recording))
+            record_frame(recording, curr_grid, generation);
+
+        if (toggle_tracking)
+        {
+            if (tracking)
+            {
+                destroy_tracker(tracking);
+                tracking = NULL;
+            }
+            else
+            {
+                tracking = create_tracker(dict, CELL_ROW_COUNT, CELL_COL_COUNT,
+                                          grid_size, generation);
+            }
+        }
+
+        if (tracking && (iterate || toggle_tracking))
+            track_frame(tracking, curr_grid, generation);
+
+        if (take_snapshot)
+        {
+            if (!checkpoints)
+                checkpoints = create_recorder("checkpoint.bin", CELL_TOT_ROW,
+                                              CELL_TOT_COL, grid_size);
+            if (checkpoints)
+                record_frame(checkpoints, curr_grid, generation);
+        }
 
         SDL_RenderClear(renderer);
         draw_grid(curr_grid,
@@ -607,13 +3629,27 @@ main(int argc, char** argv)
                   CELL_COL_COUNT,
                   renderer);
 
+        if (damage)
+            draw_damage(damage, curr_grid, CELL_ROW_COUNT, CELL_COL_COUNT, renderer);
+
         SDL_RenderPresent(renderer);
 
         SDL_Delay(60);
     }
 
+    if (recording)
+        destroy_recorder(recording);
+    if (checkpoints)
+        destroy_recorder(checkpoints);
+    if (tracking)
+        destroy_tracker(tracking);
+    if (damage)
+        destroy_damage(damage);
+
     destroy_threads(&threads);
 
+    destroy_tile_summary(&tiles);
+    free(dict);
     free(curr_grid);
 
     sdl_shutdown(window, renderer);
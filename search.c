@@ -0,0 +1,2023 @@
+/////////////////////////////////////////////////////////////////////
+/// Row-by-row search for oscillators and spaceships.
+/// Line of thought:
+/// - Representation:
+///     A pattern of period P is described by its P phases,
+///     each phase a stack of rows of at most SEARCH_MAX_WIDTH cells.
+///     The search builds all phases together, one row at a time,
+///     in the order row k of phase 0, row k of phase 1, ...
+///     Row k of phase p + 1 is decided by rows k - 1, k, k + 1
+///     of phase p, so each new row must make the row above it
+///     evolve into the matching row of the next phase.
+///     For the last phase the "next phase" is phase 0, moved
+///     up by the shift (0 for oscillators, 1 for c/P spaceships).
+/// - Rule as lookup table:
+///     The rule is compiled to a table over the 9 bit
+///     neighbourhood of a cell. New rows are enumerated one
+///     column at a time, column x - 1 is checked against the
+///     table as soon as column x is chosen, so dead branches are
+///     cut after a single bit.
+/// - Parallelism:
+///     Each worker runs a depth first search on its own stack.
+///     While a worker's deque is short, it moves the siblings of
+///     the node it expands into the deque as tasks, other workers
+///     steal from the bottom of the deques, which is where the
+///     largest subtrees are.
+/// - Checkpoints:
+///     Every CHECKPOINT_INTERVAL seconds all workers flush their
+///     stacks into their deques and pause, and the deques are
+///     written to the checkpoint file. Starting with an existing
+///     checkpoint file resumes the search from there.
+///
+/// - Predecessors:
+///     The same row-by-row search runs backwards in time:
+///     rows of the predecessor are chosen so that the row above
+///     evolves into the matching row of the target. Cells outside
+///     the bounding box are dead, so an exhausted search proves
+///     there is no predecessor within the box.
+///
+/// - Collisions:
+///     Two or three gliders are aimed at each other over every
+///     lane offset and timing, each collision runs in a 64 x 64
+///     universe of one word per row until it settles. Gliders that
+///     fly off are removed and counted, and the settled result is
+///     classified by its canonical hash, minimized over its phases.
+///
+/// Restrictions:
+/// -   Shift must be 0 or 1, faster ships need a different row order
+///     to keep every new row constrained.
+/// -   Only asymmetric searches, so every solution is found in
+///     all its orientations and positions, and reported once.
+/////////////////////////////////////////////////////////////////////
+
+#define _GNU_SOURCE
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <time.h>
+
+#define THREAD_COUNT 8
+
+#define SEARCH_MAX_WIDTH 24
+#define SEARCH_MAX_PERIOD 8
+#define SEARCH_MAX_ROWS 48
+// Empty rows kept above the pattern, so the first rows
+// are checked against an empty neighbourhood.
+#define SEARCH_MARGIN 2
+#define SEARCH_MAX_DEPTH ((SEARCH_MAX_ROWS + SEARCH_MARGIN) * SEARCH_MAX_PERIOD)
+
+// Workers only split work off while their deque is shorter than this.
+#define SPLIT_THRESHOLD 32
+#define CHECKPOINT_INTERVAL 60
+
+// Largest pattern that can be hashed.
+#define PATTERN_MAX_SIZE 64
+
+// Collision universe, one word per row
+#define COLLISION_SIZE 64
+// Objects this close to the edge are removed (gliders) or end the run
+#define COLLISION_EDGE 4
+// Distance of the gliders from the center at generation 0
+#define COLLISION_DISTANCE 12
+#define COLLISION_MAX_OFFSET 8
+#define COLLISION_MAX_TIMING 32
+// Longest period recognized as settled
+#define COLLISION_MAX_PERIOD 32
+
+#if (SEARCH_MAX_ROWS + SEARCH_MARGIN > PATTERN_MAX_SIZE)
+#error "SEARCH_MAX_ROWS does not fit in a pattern"
+#endif
+
+///////////////////////////////////////////////////////////
+/// Rule
+///////////////////////////////////////////////////////////
+typedef uint32_t row_bits;
+
+// Next state of the center cell, indexed by the 3x3 neighbourhood:
+// bits 0-2 row above, 3-5 the row itself, 6-8 row below.
+uint8_t rule_table[512];
+
+void
+init_rule_table()
+{
+    for (size_t i = 0; i != 512; ++i)
+    {
+        const int alive = (i >> 4) & 1;
+        const int neighbors = __builtin_popcount(i & ~(1u << 4));
+        rule_table[i] = (neighbors == 3 || (alive && neighbors == 2));
+    }
+}
+
+// Next state of 64 cells at once, given the 8 words of their
+// neighbours (already shifted into place) and their current state.
+uint64_t
+life_rule_word(const uint64_t neighbors[8],
+               const uint64_t alive)
+{
+    const uint64_t a_xor = neighbors[0] ^ neighbors[1];
+    const uint64_t a_sum = a_xor ^ neighbors[2];
+    const uint64_t a_carry = (neighbors[0] & neighbors[1]) | (a_xor & neighbors[2]);
+
+    const uint64_t b_xor = neighbors[3] ^ neighbors[4];
+    const uint64_t b_sum = b_xor ^ neighbors[5];
+    const uint64_t b_carry = (neighbors[3] & neighbors[4]) | (b_xor & neighbors[5]);
+
+    const uint64_t c_sum = neighbors[6] ^ neighbors[7];
+    const uint64_t c_carry = neighbors[6] & neighbors[7];
+
+    const uint64_t d_xor = a_sum ^ b_sum;
+    const uint64_t ones = d_xor ^ c_sum;
+    const uint64_t d_carry = (a_sum & b_sum) | (d_xor & c_sum);
+
+    const uint64_t e_xor = a_carry ^ b_carry;
+    const uint64_t e_sum = e_xor ^ c_carry;
+    const uint64_t e_carry = (a_carry & b_carry) | (e_xor & c_carry);
+
+    const uint64_t twos = e_sum ^ d_carry;
+    const uint64_t f_carry = e_sum & d_carry;
+
+    return twos & ~(e_carry | f_carry) & (ones | alive);
+}
+
+///////////////////////////////////////////////////////////
+/// Patterns
+///////////////////////////////////////////////////////////
+// Same representation as the census in non_double_buffer.c,
+// one word per row, cropped to the bounding box.
+typedef struct
+{
+    uint64_t rows[PATTERN_MAX_SIZE];
+    size_t width;
+    size_t height;
+} pattern;
+
+uint64_t
+hash_combine(uint64_t hash,
+             const uint64_t val)
+{
+    hash ^= val + 0x9E3779B97F4A7C15ULL + (hash << 6) + (hash >> 2);
+    return hash * 0x100000001B3ULL;
+}
+
+uint64_t
+reverse_bits(uint64_t val)
+{
+    val = ((val >> 1) & 0x5555555555555555ULL) | ((val & 0x5555555555555555ULL) << 1);
+    val = ((val >> 2) & 0x3333333333333333ULL) | ((val & 0x3333333333333333ULL) << 2);
+    val = ((val >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((val & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(val);
+}
+
+void
+crop_pattern(pattern* pat)
+{
+    uint64_t cols = 0;
+    size_t first_row = PATTERN_MAX_SIZE;
+    size_t last_row = 0;
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+    {
+        if (pat->rows[i])
+        {
+            first_row = (first_row == PATTERN_MAX_SIZE) ? i : first_row;
+            last_row = i;
+            cols |= pat->rows[i];
+        }
+    }
+
+    if (!cols)
+    {
+        memset(pat, 0, sizeof(pattern));
+        return;
+    }
+
+    const size_t first_col = __builtin_ctzll(cols);
+    const size_t height = last_row - first_row + 1;
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+        pat->rows[i] = (i < height) ? pat->rows[i + first_row] >> first_col : 0;
+
+    pat->height = height;
+    pat->width = 64 - __builtin_clzll(cols) - first_col;
+}
+
+// Advances the pattern one generation, the result is cropped again.
+// The pattern must leave room for one cell of growth on every side.
+void
+step_pattern(pattern* pat)
+{
+    uint64_t rows[PATTERN_MAX_SIZE + 2] = {0};
+    for (size_t i = 0; i != pat->height; ++i)
+        rows[i + 2] = pat->rows[i] << 1;
+
+    for (size_t i = 0; i != PATTERN_MAX_SIZE; ++i)
+    {
+        const uint64_t above = rows[i];
+        const uint64_t curr = rows[i + 1];
+        const uint64_t below = rows[i + 2];
+        const uint64_t neighbors[8] =
+        {
+            above << 1, above, above >> 1,
+            curr << 1, curr >> 1,
+            below << 1, below, below >> 1,
+        };
+        pat->rows[i] = life_rule_word(neighbors, curr);
+    }
+
+    crop_pattern(pat);
+}
+
+// Transposes a 64 x 64 bit matrix in place, bit j of rows[i] moves to
+// bit i of rows[j]. Each round swaps the two off diagonal blocks of
+// every block on the diagonal, 32 x 32 blocks first and single bits
+// last. A round is the same masked shift over pairs of rows, which the
+// compiler turns into vector operations.
+void
+transpose_bits_64(uint64_t rows[64])
+{
+    const uint64_t masks[6] =
+    {
+        0x00000000FFFFFFFFULL,
+        0x0000FFFF0000FFFFULL,
+        0x00FF00FF00FF00FFULL,
+        0x0F0F0F0F0F0F0F0FULL,
+        0x3333333333333333ULL,
+        0x5555555555555555ULL,
+    };
+
+    for (size_t round = 0; round != 6; ++round)
+    {
+        const size_t size = 32 >> round;
+        const uint64_t mask = masks[round];
+        for (size_t block = 0; block != 64; block += 2 * size)
+        {
+            for (size_t i = block; i != block + size; ++i)
+            {
+                const uint64_t swap = ((rows[i] >> size) ^ rows[i + size]) & mask;
+                rows[i] ^= swap << size;
+                rows[i + size] ^= swap;
+            }
+        }
+    }
+}
+
+void
+flip_bits_rows_64(uint64_t rows[64])
+{
+    for (size_t i = 0; i != 32; ++i)
+    {
+        const uint64_t tmp = rows[i];
+        rows[i] = rows[63 - i];
+        rows[63 - i] = tmp;
+    }
+}
+
+void
+flip_bits_cols_64(uint64_t rows[64])
+{
+    for (size_t i = 0; i != 64; ++i)
+        rows[i] = reverse_bits(rows[i]);
+}
+
+// Turns a 64 x 64 bit matrix clockwise, row 0 on top and bit 0 as the
+// leftmost column.
+void
+rotate_bits_64(uint64_t rows[64],
+               const size_t quarter_turns)
+{
+    switch (quarter_turns % 4)
+    {
+    case 1:
+        transpose_bits_64(rows);
+        flip_bits_cols_64(rows);
+        break;
+    case 2:
+        flip_bits_rows_64(rows);
+        flip_bits_cols_64(rows);
+        break;
+    case 3:
+        transpose_bits_64(rows);
+        flip_bits_rows_64(rows);
+        break;
+    default:
+        break;
+    }
+}
+
+// Patterns sit in the top left corner of their 64 x 64 tile. Flipping
+// or turning the tile leaves them against the bottom or the right
+// edge, this moves them back.
+void
+align_pattern(pattern* pat,
+              const bool bottom,
+              const bool right)
+{
+    if (bottom)
+    {
+        memmove(pat->rows, &pat->rows[PATTERN_MAX_SIZE - pat->height], pat->height * sizeof(uint64_t));
+        memset(&pat->rows[pat->height], 0, (PATTERN_MAX_SIZE - pat->height) * sizeof(uint64_t));
+    }
+
+    if (right)
+        for (size_t i = 0; i != pat->height; ++i)
+            pat->rows[i] >>= PATTERN_MAX_SIZE - pat->width;
+}
+
+void
+flip_rows(pattern* pat)
+{
+    flip_bits_rows_64(pat->rows);
+    align_pattern(pat, true, false);
+}
+
+void
+flip_cols(pattern* pat)
+{
+    flip_bits_cols_64(pat->rows);
+    align_pattern(pat, false, true);
+}
+
+// Turns the pattern clockwise.
+void
+rotate_pattern(pattern* pat,
+               const size_t quarter_turns)
+{
+    const size_t turns = quarter_turns % 4;
+    rotate_bits_64(pat->rows, turns);
+    if (turns % 2 != 0)
+    {
+        const size_t width = pat->width;
+        pat->width = pat->height;
+        pat->height = width;
+    }
+    align_pattern(pat, turns >= 2, turns == 1 || turns == 2);
+}
+
+uint64_t
+hash_pattern(const pattern* pat)
+{
+    uint64_t hash = hash_combine(pat->width, pat->height);
+    for (size_t i = 0; i != pat->height; ++i)
+        hash = hash_combine(hash, pat->rows[i]);
+    return hash;
+}
+
+// Smallest hash over the 8 symmetries of the pattern.
+uint64_t
+canonical_hash(const pattern* pat)
+{
+    pattern sym = (*pat);
+    uint64_t best = UINT64_MAX;
+
+    // The 4 flips, of the pattern and of its quarter turn. Column flips
+    // and clockwise turns reverse all 64 rows of the tile, row flips and
+    // counterclockwise turns only move rows, so the former are rarer.
+    for (size_t t = 0; t != 2; ++t)
+    {
+        for (size_t f = 0; f != 4; ++f)
+        {
+            const uint64_t hash = hash_pattern(&sym);
+            best = (hash < best) ? hash : best;
+
+            if (f % 2 == 0)
+                flip_rows(&sym);
+            else if (f == 1)
+                flip_cols(&sym);
+        }
+        if (t == 0)
+            rotate_pattern(&sym, 3);
+    }
+
+    return best;
+}
+
+void
+print_pattern(const pattern* pat)
+{
+    for (size_t i = 0; i != pat->height; ++i)
+    {
+        for (size_t j = 0; j != pat->width; ++j)
+            putchar((pat->rows[i] >> j) & 1 ? 'o' : '.');
+        putchar('\n');
+    }
+}
+
+///////////////////////////////////////////////////////////
+/// Row search
+///////////////////////////////////////////////////////////
+typedef enum
+{
+    SEARCH_PERIODIC,
+    SEARCH_PREDECESSOR,
+} search_mode;
+
+typedef struct
+{
+    search_mode mode;
+    size_t period;
+    size_t shift;
+    size_t width;
+    size_t max_rows;
+
+    // Predecessor search only, the pattern to reach.
+    // Period is 1, width and max_rows are the bounding box.
+    row_bits target[SEARCH_MAX_ROWS];
+    size_t max_solutions;
+} search_params;
+
+// A node of the search tree: the rows decided so far,
+// in the order row 0 phase 0, row 0 phase 1, ..., row 1 phase 0 ...
+typedef struct
+{
+    size_t depth;
+    row_bits rows[SEARCH_MAX_DEPTH];
+} search_task;
+
+bool
+column_matches(const uint64_t above,
+               const uint64_t curr,
+               const uint64_t below,
+               const uint64_t target,
+               const size_t col)
+{
+    // Rows are shifted up by 2, so column -2 is bit 0
+    const size_t idx = ((above >> col) & 7) |
+                       (((curr >> col) & 7) << 3) |
+                       (((below >> col) & 7) << 6);
+    return rule_table[idx] == ((target >> (col + 1)) & 1);
+}
+
+typedef struct
+{
+    uint64_t above;
+    uint64_t curr;
+    uint64_t target;
+    size_t width;
+    row_bits** out;
+    size_t* capacity;
+    size_t count;
+} extend_state;
+
+// Chooses column x of the new row, checking column x - 1,
+// the last two columns are checked once the row is complete.
+void
+extend_column(extend_state* st,
+              const uint64_t below,
+              const size_t x)
+{
+    if (x == st->width)
+    {
+        if (column_matches(st->above, st->curr, below, st->target, x) &&
+            column_matches(st->above, st->curr, below, st->target, x + 1))
+        {
+            if (st->count == (*st->capacity))
+            {
+                (*st->capacity) = (*st->capacity) ? (*st->capacity) * 2 : 16;
+                (*st->out) = realloc((*st->out), (*st->capacity) * sizeof(row_bits));
+            }
+            (*st->out)[st->count++] = (row_bits)(below >> 2);
+        }
+        return;
+    }
+
+    for (uint64_t bit = 0; bit != 2; ++bit)
+    {
+        const uint64_t next = below | (bit << (x + 2));
+        if (column_matches(st->above, st->curr, next, st->target, x))
+            extend_column(st, next, x + 1);
+    }
+}
+
+// All rows below 'curr' that make 'curr' evolve into 'target',
+// without births outside the search width.
+// The output buffer grows as needed.
+size_t
+extend_row(const row_bits above,
+           const row_bits curr,
+           const row_bits target,
+           const size_t width,
+           row_bits** out,
+           size_t* capacity)
+{
+    extend_state st =
+    {
+        .above = (uint64_t)above << 2,
+        .curr = (uint64_t)curr << 2,
+        .target = (uint64_t)target << 2,
+        .width = width,
+        .out = out,
+        .capacity = capacity,
+        .count = 0,
+    };
+    extend_column(&st, 0, 0);
+    return st.count;
+}
+
+// Whether the row evolves into 'target', without births outside the width.
+bool
+row_evolves(const row_bits above,
+            const row_bits curr,
+            const row_bits below,
+            const row_bits target,
+            const size_t width)
+{
+    for (size_t x = 0; x != width + 2; ++x)
+    {
+        if (!column_matches((uint64_t)above << 2, (uint64_t)curr << 2,
+                            (uint64_t)below << 2, (uint64_t)target << 2, x))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Row of the predecessor target, empty outside the bounding box.
+row_bits
+get_target_row(const search_params* params,
+               const size_t row)
+{
+    return (row < params->max_rows) ? params->target[row] : 0;
+}
+
+row_bits
+get_row(const search_params* params,
+        const row_bits* rows,
+        const size_t row,
+        const size_t phase)
+{
+    return rows[row * params->period + phase];
+}
+
+// Candidates for the row at depth, given all rows before it.
+size_t
+expand_node(const search_params* params,
+            const row_bits* rows,
+            const size_t depth,
+            row_bits** out,
+            size_t* capacity)
+{
+    const size_t row = depth / params->period;
+    const size_t phase = depth % params->period;
+
+    if (params->mode == SEARCH_PREDECESSOR)
+    {
+        // Row 'depth - 1' is complete once its lower neighbour is chosen,
+        // its next generation is the target row above it.
+        return extend_row(rows[depth - 2], rows[depth - 1],
+                          get_target_row(params, depth - 1 - SEARCH_MARGIN),
+                          params->width, out, capacity);
+    }
+
+    const row_bits above = get_row(params, rows, row - 2, phase);
+    const row_bits curr = get_row(params, rows, row - 1, phase);
+    const row_bits target = (phase + 1 != params->period)
+                          ? get_row(params, rows, row - 1, phase + 1)
+                          : get_row(params, rows, row - 1 + params->shift, 0);
+
+    size_t count = extend_row(above, curr, target, params->width, out, capacity);
+
+    // The first row must not be empty in every phase,
+    // otherwise the search would only push the pattern down.
+    if (row == SEARCH_MARGIN && phase + 1 == params->period)
+    {
+        bool empty = true;
+        for (size_t i = 0; i + 1 != params->period; ++i)
+            empty &= get_row(params, rows, row, i) == 0;
+
+        if (empty)
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i != count; ++i)
+                if ((*out)[i] != 0)
+                    (*out)[kept++] = (*out)[i];
+            count = kept;
+        }
+    }
+
+    return count;
+}
+
+bool
+row_is_empty(const search_params* params,
+             const row_bits* rows,
+             const size_t row)
+{
+    for (size_t i = 0; i != params->period; ++i)
+        if (get_row(params, rows, row, i) != 0)
+            return false;
+    return true;
+}
+
+// Whether the node is a leaf that holds a complete pattern.
+bool
+is_complete(const search_params* params,
+            const row_bits* rows,
+            const size_t depth)
+{
+    const size_t row = depth / params->period;
+
+    if (params->mode == SEARCH_PREDECESSOR)
+        return row == params->max_rows + SEARCH_MARGIN;
+
+    // Two empty rows in every phase end the pattern
+    return depth % params->period == 0 &&
+           row >= SEARCH_MARGIN + 2 &&
+           row_is_empty(params, rows, row - 1) &&
+           row_is_empty(params, rows, row - 2);
+}
+
+void
+build_phase(const search_params* params,
+            const row_bits* rows,
+            const size_t row_count,
+            const size_t phase,
+            pattern* out)
+{
+    memset(out, 0, sizeof(pattern));
+    for (size_t i = 0; i != row_count; ++i)
+        out->rows[i] = get_row(params, rows, i, phase);
+    crop_pattern(out);
+}
+
+///////////////////////////////////////////////////////////
+/// Work stealing
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    search_task* tasks;
+    size_t begin;
+    size_t end;
+    size_t capacity;
+    pthread_mutex_t mtx;
+} task_deque;
+
+void
+push_task(task_deque* deque,
+          const search_task* task)
+{
+    pthread_mutex_lock(&deque->mtx);
+    if (deque->end == deque->capacity)
+    {
+        // Compact before growing, stolen tasks leave room at the bottom
+        const size_t count = deque->end - deque->begin;
+        if (deque->begin > count)
+        {
+            memmove(deque->tasks, &deque->tasks[deque->begin], count * sizeof(search_task));
+        }
+        else
+        {
+            deque->capacity = deque->capacity ? deque->capacity * 2 : 64;
+            search_task* tasks = malloc(deque->capacity * sizeof(search_task));
+            if (count)
+                memcpy(tasks, &deque->tasks[deque->begin], count * sizeof(search_task));
+            free(deque->tasks);
+            deque->tasks = tasks;
+        }
+        deque->begin = 0;
+        deque->end = count;
+    }
+
+    // Only the rows up to depth are meaningful
+    search_task* dst = &deque->tasks[deque->end++];
+    dst->depth = task->depth;
+    memcpy(dst->rows, task->rows, task->depth * sizeof(row_bits));
+    pthread_mutex_unlock(&deque->mtx);
+}
+
+// Owner takes from the top (deepest work), thieves from the bottom.
+bool
+pop_task(task_deque* deque,
+         search_task* out,
+         const bool steal)
+{
+    pthread_mutex_lock(&deque->mtx);
+    const bool found = deque->begin != deque->end;
+    if (found)
+    {
+        const search_task* task = steal ? &deque->tasks[deque->begin++]
+                                        : &deque->tasks[--deque->end];
+        out->depth = task->depth;
+        memcpy(out->rows, task->rows, task->depth * sizeof(row_bits));
+    }
+    pthread_mutex_unlock(&deque->mtx);
+    return found;
+}
+
+size_t
+deque_size(task_deque* deque)
+{
+    pthread_mutex_lock(&deque->mtx);
+    const size_t size = deque->end - deque->begin;
+    pthread_mutex_unlock(&deque->mtx);
+    return size;
+}
+
+// Solutions are reported once, by the smallest canonical hash of their phases.
+typedef struct
+{
+    uint64_t* hashes;
+    size_t count;
+    size_t capacity;
+    pthread_mutex_t mtx;
+} solution_set;
+
+// Returns the number of solutions once the hash is in, or 0 if it was
+// already there or the set holds limit solutions. A limit of 0 is none.
+size_t
+insert_solution(solution_set* set,
+                const uint64_t hash,
+                const size_t limit)
+{
+    pthread_mutex_lock(&set->mtx);
+    if (limit != 0 && set->count >= limit)
+    {
+        pthread_mutex_unlock(&set->mtx);
+        return 0;
+    }
+
+    if (set->count * 2 >= set->capacity)
+    {
+        const size_t old_capacity = set->capacity;
+        uint64_t* old_hashes = set->hashes;
+
+        set->capacity = old_capacity ? old_capacity * 2 : 64;
+        set->hashes = calloc(set->capacity, sizeof(uint64_t));
+        set->count = 0;
+
+        for (size_t i = 0; i != old_capacity; ++i)
+        {
+            if (!old_hashes[i])
+                continue;
+            size_t idx = old_hashes[i] & (set->capacity - 1);
+            while (set->hashes[idx])
+                idx = (idx + 1) & (set->capacity - 1);
+            set->hashes[idx] = old_hashes[i];
+            set->count++;
+        }
+        free(old_hashes);
+    }
+
+    // Zero marks empty slots
+    const uint64_t key = hash ? hash : 1;
+    size_t idx = key & (set->capacity - 1);
+    bool inserted = true;
+    while (set->hashes[idx])
+    {
+        if (set->hashes[idx] == key)
+        {
+            inserted = false;
+            break;
+        }
+        idx = (idx + 1) & (set->capacity - 1);
+    }
+
+    size_t count = 0;
+    if (inserted)
+    {
+        set->hashes[idx] = key;
+        count = ++set->count;
+    }
+    pthread_mutex_unlock(&set->mtx);
+    return count;
+}
+
+typedef struct
+{
+    search_params params;
+    task_deque deques[THREAD_COUNT];
+    solution_set solutions;
+    const char* checkpoint_path;
+    atomic_size_t nodes;
+
+    // Synchronization vars
+    atomic_int idle;
+    atomic_bool done;
+    atomic_bool checkpoint_requested;
+    atomic_int paused;
+    pthread_cond_t cv;
+    pthread_mutex_t cv_mtx;
+    pthread_mutex_t print_mtx;
+} search_state;
+
+// One level of a worker's depth first search.
+typedef struct
+{
+    row_bits* candidates;
+    size_t capacity;
+    size_t count;
+    size_t next;
+} search_frame;
+
+typedef struct
+{
+    search_state* state;
+    size_t id;
+    // Current path, frames[i] holds the candidates for rows[base + i]
+    search_task node;
+    size_t base;
+    search_frame frames[SEARCH_MAX_DEPTH];
+    size_t frame_count;
+} worker_params;
+
+// Checks that the rows describe a pattern with exactly the
+// requested period, and reports it if it is new.
+void
+report_solution(search_state* state,
+                const row_bits* rows,
+                const size_t row_count)
+{
+    const search_params* params = &state->params;
+
+    pattern phases[SEARCH_MAX_PERIOD];
+    uint64_t hash = UINT64_MAX;
+    for (size_t i = 0; i != params->period; ++i)
+    {
+        build_phase(params, rows, row_count, i, &phases[i]);
+        const uint64_t phase_hash = canonical_hash(&phases[i]);
+        hash = (phase_hash < hash) ? phase_hash : hash;
+    }
+
+    // Patterns of a smaller period are also solutions, skip them
+    pattern pat = phases[0];
+    const uint64_t start = hash_pattern(&pat);
+    for (size_t i = 1; i != params->period; ++i)
+    {
+        step_pattern(&pat);
+        if (hash_pattern(&pat) == start)
+            return;
+    }
+
+    if (!insert_solution(&state->solutions, hash, 0))
+        return;
+
+    pthread_mutex_lock(&state->print_mtx);
+    printf("found period %zu, shift %zu, %zu x %zu:\n",
+           params->period, params->shift, phases[0].width, phases[0].height);
+    print_pattern(&phases[0]);
+    printf("\n");
+    fflush(stdout);
+    pthread_mutex_unlock(&state->print_mtx);
+}
+
+// Checks that the last rows of the box evolve into the target,
+// and reports the predecessor. Stops the search once enough are found.
+void
+report_predecessor(search_state* state,
+                   const row_bits* rows)
+{
+    const search_params* params = &state->params;
+    const row_bits* box = &rows[SEARCH_MARGIN];
+    const size_t height = params->max_rows;
+
+    if (!row_evolves(height > 1 ? box[height - 2] : 0, box[height - 1], 0,
+                     get_target_row(params, height - 1), params->width) ||
+        !row_evolves(box[height - 1], 0, 0, 0, params->width))
+    {
+        return;
+    }
+
+    pattern pat;
+    memset(&pat, 0, sizeof(pattern));
+    for (size_t i = 0; i != height; ++i)
+        pat.rows[i] = box[i];
+    pat.width = params->width;
+    pat.height = height;
+
+    // Every leaf is a different predecessor, the hash only keeps the count.
+    // Past the limit nothing is inserted, other workers may still get here.
+    const size_t count = insert_solution(&state->solutions, hash_pattern(&pat),
+                                         params->max_solutions);
+    if (count == 0)
+        return;
+
+    crop_pattern(&pat);
+    pthread_mutex_lock(&state->print_mtx);
+    printf("found predecessor, %zu x %zu:\n", pat.width, pat.height);
+    print_pattern(&pat);
+    printf("\n");
+    fflush(stdout);
+    pthread_mutex_unlock(&state->print_mtx);
+
+    if (count == params->max_solutions)
+    {
+        pthread_mutex_lock(&state->cv_mtx);
+        atomic_store_explicit(&state->done, true, memory_order_release);
+        pthread_cond_broadcast(&state->cv);
+        pthread_mutex_unlock(&state->cv_mtx);
+    }
+}
+
+// Moves the current node and every unexplored sibling on the stack
+// into the deque. Shallow tasks are pushed first, so the owner
+// continues with the deepest ones and thieves take the largest.
+void
+flush_frames(worker_params* worker)
+{
+    task_deque* deque = &worker->state->deques[worker->id];
+    search_task* node = &worker->node;
+    const size_t depth = node->depth;
+
+    for (size_t i = 0; i != worker->frame_count; ++i)
+    {
+        search_frame* frame = &worker->frames[i];
+        const row_bits chosen = node->rows[worker->base + i];
+
+        node->depth = worker->base + i + 1;
+        for (size_t c = frame->next; c != frame->count; ++c)
+        {
+            node->rows[worker->base + i] = frame->candidates[c];
+            push_task(deque, node);
+        }
+        node->rows[worker->base + i] = chosen;
+    }
+
+    node->depth = depth;
+    push_task(deque, node);
+    worker->frame_count = 0;
+}
+
+// Runs the subtree below worker->node until it is exhausted,
+// or a checkpoint asks for the stack to be flushed.
+void
+run_task(worker_params* worker)
+{
+    search_state* state = worker->state;
+    const search_params* params = &state->params;
+    task_deque* deque = &state->deques[worker->id];
+    search_task* node = &worker->node;
+    const size_t max_depth = (params->max_rows + SEARCH_MARGIN) * params->period;
+
+    worker->base = node->depth;
+    worker->frame_count = 0;
+
+    while (true)
+    {
+        // node->depth == base + frame_count, visit the node
+        if (atomic_load_explicit(&state->done, memory_order_relaxed))
+            return;
+
+        if (atomic_load_explicit(&state->checkpoint_requested, memory_order_relaxed))
+        {
+            flush_frames(worker);
+            return;
+        }
+
+        atomic_fetch_add_explicit(&state->nodes, 1, memory_order_relaxed);
+        const size_t depth = node->depth;
+
+        if (is_complete(params, node->rows, depth))
+        {
+            if (params->mode == SEARCH_PREDECESSOR)
+                report_predecessor(state, node->rows);
+            else
+                report_solution(state, node->rows, depth / params->period);
+        }
+        else if (depth < max_depth)
+        {
+            search_frame* frame = &worker->frames[worker->frame_count++];
+            frame->count = expand_node(params, node->rows, depth,
+                                       &frame->candidates, &frame->capacity);
+            frame->next = 0;
+
+            if (frame->count > 1 && deque_size(deque) < SPLIT_THRESHOLD)
+            {
+                // Hand the siblings to the deque, keep the first
+                node->depth = depth + 1;
+                for (size_t i = 1; i != frame->count; ++i)
+                {
+                    node->rows[depth] = frame->candidates[i];
+                    push_task(deque, node);
+                }
+                node->depth = depth;
+                frame->count = 1;
+            }
+        }
+
+        // Move to the next unexplored candidate, backtracking as needed
+        while (worker->frame_count != 0 &&
+               worker->frames[worker->frame_count - 1].next ==
+               worker->frames[worker->frame_count - 1].count)
+        {
+            worker->frame_count--;
+        }
+
+        if (worker->frame_count == 0)
+            return;
+
+        search_frame* frame = &worker->frames[worker->frame_count - 1];
+        node->rows[worker->base + worker->frame_count - 1] = frame->candidates[frame->next++];
+        node->depth = worker->base + worker->frame_count;
+    }
+}
+
+void
+wait_for_checkpoint(search_state* state)
+{
+    pthread_mutex_lock(&state->cv_mtx);
+    atomic_fetch_add_explicit(&state->paused, 1, memory_order_acq_rel);
+    pthread_cond_broadcast(&state->cv);
+    while (atomic_load_explicit(&state->checkpoint_requested, memory_order_acquire))
+        pthread_cond_wait(&state->cv, &state->cv_mtx);
+    atomic_fetch_sub_explicit(&state->paused, 1, memory_order_acq_rel);
+    pthread_mutex_unlock(&state->cv_mtx);
+}
+
+bool
+steal_task(worker_params* worker)
+{
+    for (size_t i = 1; i != THREAD_COUNT; ++i)
+    {
+        const size_t victim = (worker->id + i) % THREAD_COUNT;
+        if (pop_task(&worker->state->deques[victim], &worker->node, true))
+            return true;
+    }
+    return false;
+}
+
+bool
+has_tasks(search_state* state)
+{
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        if (deque_size(&state->deques[i]) != 0)
+            return true;
+    return false;
+}
+
+void*
+worker_execution(void* params)
+{
+    worker_params* worker = (worker_params*)params;
+    search_state* state = worker->state;
+
+    while (!atomic_load_explicit(&state->done, memory_order_acquire))
+    {
+        if (atomic_load_explicit(&state->checkpoint_requested, memory_order_acquire))
+        {
+            wait_for_checkpoint(state);
+            continue;
+        }
+
+        if (pop_task(&state->deques[worker->id], &worker->node, false) ||
+            steal_task(worker))
+        {
+            run_task(worker);
+            continue;
+        }
+
+        // Nothing to do, the search is over once every worker is idle.
+        // Only busy workers create tasks, so no new work can show up then.
+        atomic_fetch_add_explicit(&state->idle, 1, memory_order_acq_rel);
+        while (true)
+        {
+            if (atomic_load_explicit(&state->done, memory_order_acquire) ||
+                atomic_load_explicit(&state->checkpoint_requested, memory_order_acquire) ||
+                has_tasks(state))
+            {
+                break;
+            }
+
+            if (atomic_load_explicit(&state->idle, memory_order_acquire) == THREAD_COUNT)
+            {
+                pthread_mutex_lock(&state->cv_mtx);
+                atomic_store_explicit(&state->done, true, memory_order_release);
+                pthread_cond_broadcast(&state->cv);
+                pthread_mutex_unlock(&state->cv_mtx);
+                break;
+            }
+
+            const struct timespec delay = { .tv_sec = 0, .tv_nsec = 100000 };
+            nanosleep(&delay, NULL);
+        }
+        atomic_fetch_sub_explicit(&state->idle, 1, memory_order_acq_rel);
+    }
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////
+/// Checkpoints
+///////////////////////////////////////////////////////////
+// Binary file: magic, search parameters, the hashes of the
+// solutions found so far, then every queued task.
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t mode;
+    uint64_t target_hash;
+    uint64_t period;
+    uint64_t shift;
+    uint64_t width;
+    uint64_t max_rows;
+    uint64_t solution_count;
+    uint64_t task_count;
+} checkpoint_header;
+
+uint64_t
+hash_target(const search_params* params)
+{
+    uint64_t hash = 0;
+    for (size_t i = 0; i != params->max_rows; ++i)
+        hash = hash_combine(hash, params->target[i]);
+    return hash;
+}
+
+bool
+write_checkpoint(search_state* state)
+{
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", state->checkpoint_path);
+
+    FILE* file = fopen(tmp_path, "wb");
+    if (!file)
+    {
+        perror("write_checkpoint");
+        return false;
+    }
+
+    checkpoint_header header =
+    {
+        .magic = { 'G', 'O', 'L', 'S' },
+        .version = 1,
+        .mode = state->params.mode,
+        .target_hash = hash_target(&state->params),
+        .period = state->params.period,
+        .shift = state->params.shift,
+        .width = state->params.width,
+        .max_rows = state->params.max_rows,
+        .solution_count = state->solutions.count,
+        .task_count = 0,
+    };
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        header.task_count += state->deques[i].end - state->deques[i].begin;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (size_t i = 0; i != state->solutions.capacity && ok; ++i)
+        if (state->solutions.hashes[i])
+            ok = fwrite(&state->solutions.hashes[i], sizeof(uint64_t), 1, file) == 1;
+
+    for (size_t i = 0; i != THREAD_COUNT && ok; ++i)
+    {
+        const task_deque* deque = &state->deques[i];
+        for (size_t t = deque->begin; t != deque->end && ok; ++t)
+        {
+            const uint64_t depth = deque->tasks[t].depth;
+            ok = fwrite(&depth, sizeof(depth), 1, file) == 1 &&
+                 fwrite(deque->tasks[t].rows, sizeof(row_bits), depth, file) == depth;
+        }
+    }
+
+    ok &= fclose(file) == 0;
+    if (ok)
+        ok = rename(tmp_path, state->checkpoint_path) == 0;
+
+    if (!ok)
+        perror("write_checkpoint");
+    else
+        printf("checkpoint: %lu tasks, %zu nodes searched\n",
+               (unsigned long)header.task_count,
+               atomic_load_explicit(&state->nodes, memory_order_relaxed));
+    return ok;
+}
+
+// Returns false if there is no usable checkpoint.
+bool
+read_checkpoint(search_state* state)
+{
+    FILE* file = fopen(state->checkpoint_path, "rb");
+    if (!file)
+        return false;
+
+    checkpoint_header header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, "GOLS", 4) == 0 &&
+              header.version == 1 &&
+              header.mode == state->params.mode &&
+              header.target_hash == hash_target(&state->params) &&
+              header.period == state->params.period &&
+              header.shift == state->params.shift &&
+              header.width == state->params.width &&
+              header.max_rows == state->params.max_rows;
+
+    if (!ok)
+    {
+        fprintf(stderr, "%s does not match this search, starting over\n",
+                state->checkpoint_path);
+        fclose(file);
+        return false;
+    }
+
+    for (uint64_t i = 0; i != header.solution_count && ok; ++i)
+    {
+        uint64_t hash;
+        ok = fread(&hash, sizeof(hash), 1, file) == 1;
+        if (ok)
+            insert_solution(&state->solutions, hash, 0);
+    }
+
+    search_task task;
+    for (uint64_t i = 0; i != header.task_count && ok; ++i)
+    {
+        uint64_t depth;
+        ok = fread(&depth, sizeof(depth), 1, file) == 1 &&
+             depth <= SEARCH_MAX_DEPTH &&
+             fread(task.rows, sizeof(row_bits), depth, file) == depth;
+        task.depth = depth;
+        if (ok)
+            push_task(&state->deques[i % THREAD_COUNT], &task);
+    }
+
+    fclose(file);
+    if (ok)
+        printf("resumed %lu tasks from %s\n",
+               (unsigned long)header.task_count, state->checkpoint_path);
+    return ok;
+}
+
+///////////////////////////////////////////////////////////
+/// Driver
+///////////////////////////////////////////////////////////
+void
+run_search(search_state* state)
+{
+    pthread_t threads[THREAD_COUNT];
+    worker_params* workers = calloc(THREAD_COUNT, sizeof(worker_params));
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        workers[i].state = state;
+        workers[i].id = i;
+        pthread_create(&threads[i], NULL, worker_execution, &workers[i]);
+    }
+
+    // Main thread only takes checkpoints
+    time_t last_checkpoint = time(NULL);
+    while (!atomic_load_explicit(&state->done, memory_order_acquire))
+    {
+        const struct timespec delay = { .tv_sec = 0, .tv_nsec = 100000000 };
+        nanosleep(&delay, NULL);
+
+        if (!state->checkpoint_path ||
+            time(NULL) - last_checkpoint < CHECKPOINT_INTERVAL)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&state->cv_mtx);
+        atomic_store_explicit(&state->checkpoint_requested, true, memory_order_release);
+        while (atomic_load_explicit(&state->paused, memory_order_acquire) != THREAD_COUNT &&
+               !atomic_load_explicit(&state->done, memory_order_acquire))
+        {
+            pthread_cond_wait(&state->cv, &state->cv_mtx);
+        }
+
+        if (!atomic_load_explicit(&state->done, memory_order_acquire))
+            write_checkpoint(state);
+
+        atomic_store_explicit(&state->checkpoint_requested, false, memory_order_release);
+        pthread_cond_broadcast(&state->cv);
+        pthread_mutex_unlock(&state->cv_mtx);
+
+        last_checkpoint = time(NULL);
+    }
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        pthread_join(threads[i], NULL);
+
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        for (size_t d = 0; d != SEARCH_MAX_DEPTH; ++d)
+            free(workers[i].frames[d].candidates);
+    free(workers);
+
+    // A finished search leaves nothing to resume
+    if (state->checkpoint_path)
+        remove(state->checkpoint_path);
+}
+
+void
+init_search_state(search_state* state)
+{
+    memset(state, 0, sizeof(search_state));
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        pthread_mutex_init(&state->deques[i].mtx, NULL);
+    pthread_mutex_init(&state->solutions.mtx, NULL);
+
+    atomic_init(&state->nodes, 0);
+    atomic_init(&state->idle, 0);
+    atomic_init(&state->done, false);
+    atomic_init(&state->checkpoint_requested, false);
+    atomic_init(&state->paused, 0);
+    pthread_cond_init(&state->cv, NULL);
+    pthread_mutex_init(&state->cv_mtx, NULL);
+    pthread_mutex_init(&state->print_mtx, NULL);
+}
+
+void
+destroy_search_state(search_state* state)
+{
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+    {
+        pthread_mutex_destroy(&state->deques[i].mtx);
+        free(state->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&state->solutions.mtx);
+    free(state->solutions.hashes);
+
+    pthread_cond_destroy(&state->cv);
+    pthread_mutex_destroy(&state->cv_mtx);
+    pthread_mutex_destroy(&state->print_mtx);
+}
+
+// Runs a search from its root, or from the checkpoint if there is one.
+size_t
+execute_search(const search_params* params,
+               const char* checkpoint_path)
+{
+    search_state* state = malloc(sizeof(search_state));
+    init_search_state(state);
+    state->params = *params;
+    state->checkpoint_path = checkpoint_path;
+
+    if (!state->checkpoint_path || !read_checkpoint(state))
+    {
+        // Root: the margin rows above the pattern, all empty
+        search_task root;
+        memset(&root, 0, sizeof(root));
+        root.depth = SEARCH_MARGIN * params->period;
+        push_task(&state->deques[0], &root);
+    }
+
+    // A checkpoint may already hold enough solutions
+    if (params->max_solutions && state->solutions.count >= params->max_solutions)
+        atomic_store_explicit(&state->done, true, memory_order_release);
+
+    run_search(state);
+
+    const size_t solutions = state->solutions.count;
+    printf("search done: %zu solutions, %zu nodes\n",
+           solutions, atomic_load_explicit(&state->nodes, memory_order_relaxed));
+
+    destroy_search_state(state);
+    free(state);
+    return solutions;
+}
+
+int
+periodic_search(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        fprintf(stderr, "usage: %s periodic <period> <shift> <width> [max_rows] [checkpoint]\n",
+                argv[0]);
+        return 1;
+    }
+
+    search_params params =
+    {
+        .mode = SEARCH_PERIODIC,
+        .period = strtoul(argv[2], NULL, 10),
+        .shift = strtoul(argv[3], NULL, 10),
+        .width = strtoul(argv[4], NULL, 10),
+        .max_rows = (argc > 5) ? strtoul(argv[5], NULL, 10) : SEARCH_MAX_ROWS,
+    };
+
+    if (params.period == 0 || params.period > SEARCH_MAX_PERIOD ||
+        params.shift > 1 || params.shift >= params.period + (params.period == 1) ||
+        params.width == 0 || params.width > SEARCH_MAX_WIDTH ||
+        params.max_rows == 0 || params.max_rows > SEARCH_MAX_ROWS)
+    {
+        fprintf(stderr, "period must be 1-%d, shift 0 or 1 (below the period), "
+                        "width 1-%d and max_rows 1-%d\n",
+                SEARCH_MAX_PERIOD, SEARCH_MAX_WIDTH, SEARCH_MAX_ROWS);
+        return 1;
+    }
+
+    return execute_search(&params, (argc > 6) ? argv[6] : NULL);
+}
+
+// Reads rows of 'o' (alive) and '.' (dead) separated by '/'.
+bool
+parse_rows(const char* str,
+           row_bits* rows,
+           size_t* width,
+           size_t* height)
+{
+    size_t row = 0;
+    size_t col = 0;
+    (*width) = 0;
+    rows[0] = 0;
+    for (; *str; ++str)
+    {
+        if (*str == '/')
+        {
+            if (++row == SEARCH_MAX_ROWS)
+                return false;
+            rows[row] = 0;
+            col = 0;
+            continue;
+        }
+
+        if ((*str != 'o' && *str != '.') || col == SEARCH_MAX_WIDTH)
+            return false;
+
+        rows[row] |= (row_bits)(*str == 'o') << col++;
+        (*width) = (col > (*width)) ? col : (*width);
+    }
+    (*height) = row + 1;
+    return true;
+}
+
+int
+predecessor_search(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s predecessor <rows> [margin] [max_solutions] [checkpoint]\n"
+                        "rows are 'o' and '.' separated by '/', e.g. .o./..o/ooo\n",
+                argv[0]);
+        return 1;
+    }
+
+    row_bits rows[SEARCH_MAX_ROWS];
+    size_t width = 0;
+    size_t height = 0;
+    if (!parse_rows(argv[2], rows, &width, &height))
+    {
+        fprintf(stderr, "could not read the target pattern\n");
+        return 1;
+    }
+
+    // The box leaves 'margin' cells around the target for the predecessor,
+    // at least one, since the box edge must end up dead.
+    const size_t margin = (argc > 3) ? strtoul(argv[3], NULL, 10) : 1;
+    search_params params =
+    {
+        .mode = SEARCH_PREDECESSOR,
+        .period = 1,
+        .shift = 0,
+        .width = width + 2 * margin,
+        .max_rows = height + 2 * margin,
+        .max_solutions = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1,
+    };
+
+    if (margin == 0 ||
+        params.width > SEARCH_MAX_WIDTH ||
+        params.max_rows > SEARCH_MAX_ROWS)
+    {
+        fprintf(stderr, "margin must be at least 1, and the box at most %d x %d\n",
+                SEARCH_MAX_WIDTH, SEARCH_MAX_ROWS);
+        return 1;
+    }
+
+    for (size_t i = 0; i != height; ++i)
+        params.target[i + margin] = rows[i] << margin;
+
+    if (execute_search(&params, (argc > 5) ? argv[5] : NULL) == 0)
+    {
+        printf("no predecessor within the %zu x %zu box\n",
+               params.width, params.max_rows);
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////
+/// Collisions
+///////////////////////////////////////////////////////////
+typedef struct
+{
+    uint64_t rows[COLLISION_SIZE];
+} universe;
+
+// Directions a glider can fly in
+typedef enum
+{
+    GLIDER_SE,
+    GLIDER_SW,
+    GLIDER_NE,
+    GLIDER_NW,
+} glider_direction;
+
+typedef enum
+{
+    COLLISION_SETTLED,
+    // Something other than a glider reached the edge
+    COLLISION_ESCAPED,
+    // Still active after the generation limit
+    COLLISION_UNSETTLED,
+} collision_result;
+
+// One collision: glider 0 flies south east from a fixed spot,
+// the others are given by direction, lane offset and timing.
+typedef struct
+{
+    size_t glider_count;
+    glider_direction directions[3];
+    int offsets[3];
+    size_t timings[3];
+} collision;
+
+typedef struct
+{
+    uint64_t key;
+    size_t count;
+    collision_result result;
+    size_t period;
+    size_t population;
+    size_t gliders;
+    collision example;
+    pattern settled;
+} collision_outcome;
+
+typedef struct
+{
+    size_t glider_count;
+    size_t max_offset;
+    size_t timing;
+    size_t max_generations;
+    size_t collision_count;
+    atomic_size_t next;
+
+    // Outcomes, deduplicated by key through an open addressing
+    // table of indices into outcomes, SIZE_MAX marks empty slots
+    collision_outcome* outcomes;
+    size_t outcome_count;
+    size_t outcome_capacity;
+    size_t* outcome_table;
+    size_t table_size;
+    pthread_mutex_t mtx;
+
+    // Canonical hashes of the 4 glider phases
+    uint64_t glider_hashes[4];
+} collision_state;
+
+// Only the rows next to live cells are computed, collisions stay small.
+void
+step_universe(universe* uni)
+{
+    size_t first = 0;
+    size_t last = COLLISION_SIZE;
+    while (first != COLLISION_SIZE && !uni->rows[first])
+        first++;
+    while (last != first && !uni->rows[last - 1])
+        last--;
+    if (first == last)
+        return;
+
+    first = (first != 0) ? first - 1 : 0;
+    last = (last != COLLISION_SIZE) ? last + 1 : COLLISION_SIZE;
+
+    universe next;
+    memset(&next, 0, sizeof(universe));
+    for (size_t i = first; i != last; ++i)
+    {
+        const uint64_t above = (i != 0) ? uni->rows[i - 1] : 0;
+        const uint64_t curr = uni->rows[i];
+        const uint64_t below = (i + 1 != COLLISION_SIZE) ? uni->rows[i + 1] : 0;
+        const uint64_t neighbors[8] =
+        {
+            above << 1, above, above >> 1,
+            curr << 1, curr >> 1,
+            below << 1, below, below >> 1,
+        };
+        next.rows[i] = life_rule_word(neighbors, curr);
+    }
+    (*uni) = next;
+}
+
+uint64_t
+hash_universe(const universe* uni)
+{
+    uint64_t hash = 0;
+    for (size_t i = 0; i != COLLISION_SIZE; ++i)
+        hash = hash_combine(hash, uni->rows[i]);
+    return hash;
+}
+
+void
+universe_to_pattern(const universe* uni,
+                    pattern* pat)
+{
+    memset(pat, 0, sizeof(pattern));
+    for (size_t i = 0; i != COLLISION_SIZE; ++i)
+        pat->rows[i] = uni->rows[i];
+    crop_pattern(pat);
+}
+
+// Places a glider with its bounding box at (x, y).
+void
+add_glider(universe* uni,
+           const glider_direction dir,
+           const int x,
+           const int y)
+{
+    // South east phase, bit 0 is the leftmost column
+    uint64_t rows[3] = { 0x2, 0x4, 0x7 };
+    if (dir == GLIDER_SW || dir == GLIDER_NW)
+    {
+        for (size_t i = 0; i != 3; ++i)
+            rows[i] = ((rows[i] & 1) << 2) | (rows[i] & 2) | ((rows[i] >> 2) & 1);
+    }
+    if (dir == GLIDER_NE || dir == GLIDER_NW)
+    {
+        const uint64_t tmp = rows[0];
+        rows[0] = rows[2];
+        rows[2] = tmp;
+    }
+
+    for (size_t i = 0; i != 3; ++i)
+        uni->rows[y + i] |= rows[i] << x;
+}
+
+// Glider i > 0 is placed at the same distance from the center as
+// glider 0, moved sideways by its lane offset and forward by its timing.
+void
+build_collision(const collision* col,
+                universe* uni)
+{
+    const int center = COLLISION_SIZE / 2 - 1;
+    const int d = COLLISION_DISTANCE;
+
+    memset(uni, 0, sizeof(universe));
+    add_glider(uni, GLIDER_SE, center - d, center - d);
+
+    for (size_t i = 1; i != col->glider_count; ++i)
+    {
+        const int k = col->offsets[i];
+        universe glider;
+        memset(&glider, 0, sizeof(universe));
+
+        switch (col->directions[i])
+        {
+        case GLIDER_NW: add_glider(&glider, GLIDER_NW, center + d + k, center + d - k); break;
+        case GLIDER_SW: add_glider(&glider, GLIDER_SW, center + d + k, center - d + k); break;
+        case GLIDER_NE: add_glider(&glider, GLIDER_NE, center - d + k, center + d + k); break;
+        case GLIDER_SE: add_glider(&glider, GLIDER_SE, center - d + k, center - d - k); break;
+        }
+
+        for (size_t t = 0; t != col->timings[i]; ++t)
+            step_universe(&glider);
+
+        for (size_t r = 0; r != COLLISION_SIZE; ++r)
+            uni->rows[r] |= glider.rows[r];
+    }
+}
+
+// Removes the objects touching the edge zone. Returns the number of
+// gliders removed, or -1 if anything else got there.
+int
+remove_escapes(const collision_state* state,
+               universe* uni)
+{
+    const uint64_t edge_cols = ((1ULL << COLLISION_EDGE) - 1) |
+                               (((1ULL << COLLISION_EDGE) - 1) << (64 - COLLISION_EDGE));
+    int gliders = 0;
+
+    for (size_t i = 0; i != COLLISION_SIZE; ++i)
+    {
+        const bool edge_row = i < COLLISION_EDGE || i >= COLLISION_SIZE - COLLISION_EDGE;
+        while (uni->rows[i] & (edge_row ? ~0ULL : edge_cols))
+        {
+            // Flood fill the object from its lowest cell in the edge zone
+            universe object;
+            memset(&object, 0, sizeof(universe));
+            const uint64_t seed = uni->rows[i] & (edge_row ? ~0ULL : edge_cols);
+            object.rows[i] = seed & -seed;
+
+            bool grown = true;
+            while (grown)
+            {
+                grown = false;
+                for (size_t r = 0; r != COLLISION_SIZE; ++r)
+                {
+                    uint64_t reach = object.rows[r];
+                    if (r != 0)
+                        reach |= object.rows[r - 1];
+                    if (r + 1 != COLLISION_SIZE)
+                        reach |= object.rows[r + 1];
+                    reach = (reach | (reach << 1) | (reach >> 1)) & uni->rows[r];
+
+                    grown |= reach != object.rows[r];
+                    object.rows[r] = reach;
+                }
+            }
+
+            pattern pat;
+            universe_to_pattern(&object, &pat);
+            const uint64_t hash = canonical_hash(&pat);
+            bool glider = false;
+            for (size_t p = 0; p != 4; ++p)
+                glider |= hash == state->glider_hashes[p];
+
+            if (!glider)
+                return -1;
+
+            for (size_t r = 0; r != COLLISION_SIZE; ++r)
+                uni->rows[r] &= ~object.rows[r];
+            gliders++;
+        }
+    }
+
+    return gliders;
+}
+
+// Runs the collision until it settles, fills in everything but the count.
+void
+run_collision(const collision_state* state,
+              const collision* col,
+              collision_outcome* out)
+{
+    universe uni;
+    build_collision(col, &uni);
+
+    uint64_t history[COLLISION_MAX_PERIOD + 1] = {0};
+    size_t gliders = 0;
+
+    memset(out, 0, sizeof(collision_outcome));
+    out->example = (*col);
+    out->result = COLLISION_UNSETTLED;
+
+    for (size_t gen = 0; gen != state->max_generations; ++gen)
+    {
+        step_universe(&uni);
+
+        // Only gliders flying out can reach the edge, the ones flying in
+        // start farther away than COLLISION_EDGE
+        const int removed = remove_escapes(state, &uni);
+        if (removed < 0)
+        {
+            out->result = COLLISION_ESCAPED;
+            break;
+        }
+        gliders += removed;
+
+        const uint64_t hash = hash_universe(&uni);
+        size_t period = 0;
+        for (size_t p = 1; p <= COLLISION_MAX_PERIOD && p <= gen && !period; ++p)
+            if (history[(gen - p) % (COLLISION_MAX_PERIOD + 1)] == hash)
+                period = p;
+        history[gen % (COLLISION_MAX_PERIOD + 1)] = hash;
+
+        if (period)
+        {
+            out->result = COLLISION_SETTLED;
+            out->period = period;
+            break;
+        }
+    }
+
+    out->gliders = gliders;
+    if (out->result != COLLISION_SETTLED)
+    {
+        // Explosions and long lived results are only counted
+        out->key = hash_combine(out->result, 0);
+        return;
+    }
+
+    universe_to_pattern(&uni, &out->settled);
+    for (size_t i = 0; i != out->settled.height; ++i)
+        out->population += __builtin_popcountll(out->settled.rows[i]);
+
+    // Same outcome in any phase and orientation gets the same key
+    uint64_t key = canonical_hash(&out->settled);
+    for (size_t p = 1; p < out->period; ++p)
+    {
+        step_universe(&uni);
+        pattern phase;
+        universe_to_pattern(&uni, &phase);
+        const uint64_t hash = canonical_hash(&phase);
+        key = (hash < key) ? hash : key;
+    }
+    out->key = hash_combine(hash_combine(key, out->gliders), out->result);
+}
+
+// Decodes the collision with the given index, lanes run fastest.
+void
+get_collision(const collision_state* state,
+              size_t index,
+              collision* col)
+{
+    const size_t lanes = 2 * state->max_offset + 1;
+
+    memset(col, 0, sizeof(collision));
+    col->glider_count = state->glider_count;
+    col->directions[0] = GLIDER_SE;
+
+    // Second glider head on or from the side, third from below
+    col->directions[1] = (index % 2) ? GLIDER_SW : GLIDER_NW;
+    col->directions[2] = GLIDER_NE;
+    index /= 2;
+
+    for (size_t i = 1; i != state->glider_count; ++i)
+    {
+        col->offsets[i] = (int)(index % lanes) - (int)state->max_offset;
+        index /= lanes;
+        col->timings[i] = index % state->timing;
+        index /= state->timing;
+    }
+}
+
+size_t*
+find_outcome_slot(collision_state* state,
+                  const uint64_t key)
+{
+    size_t idx = key & (state->table_size - 1);
+    while (state->outcome_table[idx] != SIZE_MAX &&
+           state->outcomes[state->outcome_table[idx]].key != key)
+    {
+        idx = (idx + 1) & (state->table_size - 1);
+    }
+    return &state->outcome_table[idx];
+}
+
+void
+insert_outcome(collision_state* state,
+               const collision_outcome* outcome)
+{
+    pthread_mutex_lock(&state->mtx);
+    if (state->outcome_count * 2 >= state->table_size)
+    {
+        free(state->outcome_table);
+        state->table_size = state->table_size ? state->table_size * 2 : 256;
+        state->outcome_table = malloc(state->table_size * sizeof(size_t));
+        for (size_t i = 0; i != state->table_size; ++i)
+            state->outcome_table[i] = SIZE_MAX;
+        for (size_t i = 0; i != state->outcome_count; ++i)
+            (*find_outcome_slot(state, state->outcomes[i].key)) = i;
+    }
+
+    size_t* slot = find_outcome_slot(state, outcome->key);
+    if (*slot != SIZE_MAX)
+    {
+        state->outcomes[*slot].count++;
+        pthread_mutex_unlock(&state->mtx);
+        return;
+    }
+
+    if (state->outcome_count == state->outcome_capacity)
+    {
+        state->outcome_capacity = state->outcome_capacity ? state->outcome_capacity * 2 : 64;
+        state->outcomes = realloc(state->outcomes,
+                                  state->outcome_capacity * sizeof(collision_outcome));
+    }
+    state->outcomes[state->outcome_count] = (*outcome);
+    state->outcomes[state->outcome_count].count = 1;
+    (*slot) = state->outcome_count++;
+    pthread_mutex_unlock(&state->mtx);
+}
+
+void*
+collision_execution(void* params)
+{
+    collision_state* state = (collision_state*)params;
+    const size_t batch = 64;
+
+    while (true)
+    {
+        const size_t begin = atomic_fetch_add_explicit(&state->next, batch, memory_order_relaxed);
+        if (begin >= state->collision_count)
+            break;
+
+        const size_t end = (begin + batch < state->collision_count)
+                         ? begin + batch
+                         : state->collision_count;
+        for (size_t i = begin; i != end; ++i)
+        {
+            collision col;
+            collision_outcome outcome;
+            get_collision(state, i, &col);
+            run_collision(state, &col, &outcome);
+            insert_outcome(state, &outcome);
+        }
+    }
+
+    return NULL;
+}
+
+int
+compare_outcomes(const void* lhs,
+                 const void* rhs)
+{
+    const collision_outcome* a = (const collision_outcome*)lhs;
+    const collision_outcome* b = (const collision_outcome*)rhs;
+    return (a->count < b->count) - (a->count > b->count);
+}
+
+void
+print_outcome(const collision_outcome* outcome)
+{
+    const char* result = (outcome->result == COLLISION_SETTLED) ? "settled"
+                       : (outcome->result == COLLISION_ESCAPED) ? "escaped"
+                       : "unsettled";
+    if (outcome->result == COLLISION_SETTLED)
+        printf("%zu collisions, %s, period %zu, population %zu, %zu gliders out\n",
+               outcome->count, result, outcome->period, outcome->population, outcome->gliders);
+    else
+        printf("%zu collisions, %s\n", outcome->count, result);
+
+    printf("  e.g.");
+    for (size_t i = 1; i != outcome->example.glider_count; ++i)
+    {
+        const char* dir = (outcome->example.directions[i] == GLIDER_NW) ? "NW"
+                        : (outcome->example.directions[i] == GLIDER_SW) ? "SW"
+                        : "NE";
+        printf(" %s lane %d timing %zu", dir,
+               outcome->example.offsets[i], outcome->example.timings[i]);
+    }
+    printf("\n");
+
+    if (outcome->result == COLLISION_SETTLED && outcome->population)
+        print_pattern(&outcome->settled);
+    printf("\n");
+}
+
+int
+collision_search(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s collisions <gliders> [max_offset] [timing] [max_generations]\n",
+                argv[0]);
+        return 1;
+    }
+
+    collision_state* state = calloc(1, sizeof(collision_state));
+    state->glider_count = strtoul(argv[2], NULL, 10);
+    state->max_offset = (argc > 3) ? strtoul(argv[3], NULL, 10) : 6;
+    state->timing = (argc > 4) ? strtoul(argv[4], NULL, 10) : 8;
+    state->max_generations = (argc > 5) ? strtoul(argv[5], NULL, 10) : 1024;
+
+    if (state->glider_count < 2 || state->glider_count > 3 ||
+        state->max_offset > COLLISION_MAX_OFFSET ||
+        state->timing == 0 || state->timing > COLLISION_MAX_TIMING)
+    {
+        fprintf(stderr, "gliders must be 2 or 3, max_offset at most %d, timing 1-%d\n",
+                COLLISION_MAX_OFFSET, COLLISION_MAX_TIMING);
+        free(state);
+        return 1;
+    }
+
+    state->collision_count = 2;
+    for (size_t i = 1; i != state->glider_count; ++i)
+        state->collision_count *= (2 * state->max_offset + 1) * state->timing;
+    atomic_init(&state->next, 0);
+    pthread_mutex_init(&state->mtx, NULL);
+
+    universe glider;
+    memset(&glider, 0, sizeof(universe));
+    add_glider(&glider, GLIDER_SE, COLLISION_SIZE / 2, COLLISION_SIZE / 2);
+    for (size_t p = 0; p != 4; ++p)
+    {
+        pattern pat;
+        universe_to_pattern(&glider, &pat);
+        state->glider_hashes[p] = canonical_hash(&pat);
+        step_universe(&glider);
+    }
+
+    const uint64_t start = time(NULL);
+    pthread_t threads[THREAD_COUNT];
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        pthread_create(&threads[i], NULL, collision_execution, state);
+    for (size_t i = 0; i != THREAD_COUNT; ++i)
+        pthread_join(threads[i], NULL);
+
+    qsort(state->outcomes, state->outcome_count, sizeof(collision_outcome), compare_outcomes);
+    for (size_t i = 0; i != state->outcome_count; ++i)
+        print_outcome(&state->outcomes[i]);
+
+    printf("%zu collisions, %zu distinct outcomes in %lu s\n",
+           state->collision_count, state->outcome_count,
+           (unsigned long)(time(NULL) - start));
+
+    pthread_mutex_destroy(&state->mtx);
+    free(state->outcome_table);
+    free(state->outcomes);
+    free(state);
+    return 0;
+}
+
+int
+main(int argc, char** argv)
+{
+    init_rule_table();
+
+    if (argc > 1 && strcmp(argv[1], "periodic") == 0)
+        return periodic_search(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "predecessor") == 0)
+        return predecessor_search(argc, argv);
+
+    if (argc > 1 && strcmp(argv[1], "collisions") == 0)
+        return collision_search(argc, argv);
+
+    fprintf(stderr, "usage: %s periodic <period> <shift> <width> [max_rows] [checkpoint]\n"
+                    "       %s predecessor <rows> [margin] [max_solutions] [checkpoint]\n"
+                    "       %s collisions <gliders> [max_offset] [timing] [max_generations]\n",
+            argv[0], argv[0], argv[0]);
+    return 1;
+}